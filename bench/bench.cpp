@@ -0,0 +1,720 @@
+// Micro-benchmarks for the simulation, built against the host stand-ins.
+//
+//   rocketgame_bench [suite] [maxAsteroids]
+//   rocketgame_bench replay|render [file.rpl]
+//
+// Without a file, replay and render first record a scripted session.
+//
+// Run from the build directory so "romfs:/..." resolves. Results are printed
+// as CSV so CI can diff them between commits.
+#include "main.h"
+#include "audio.h"
+#include "mixer.h"
+#include "collision_mask.h"
+#include "player.h"
+#include "asteroids.h"
+#include "particles.h"
+#include "batch.h"
+#include "snapshot.h"
+#include "game.h"
+#include "timer.h"
+#include "replay.h"
+#include "random.h"
+#include "assets.h"
+#include "stress.h"
+#include "numeric.h"
+#include "atlas_index.h"
+#include "alloc_counter.h"
+
+#include <host_platform.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <string>
+
+namespace {
+
+const double FRAME_DT = 1.0 / 60.0;
+
+template<typename Fn>
+double elapsedUs(Fn && fn) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::micro>(end - start).count();
+}
+
+int iterationsFor(int count) {
+    return std::clamp(200000 / count, 3, 600);
+}
+
+void benchAsteroids(int maxCount) {
+    printf("suite,asteroids,frames,update_us,collide_us,explosions_us,draw_us,frame_us,crowded_per_frame,audio_allocs,heap_allocs,"
+           "texture_switches\n");
+    AudioManager am;
+    VoiceManager voices(am);
+    AssetArchive assets;
+    assets.open(ASSET_ARCHIVE_PATH);
+    int explosionSound = assets.sound("explosion", am.bank);
+    am.bank.materialize(explosionSound);
+    C2D_SpriteSheet atlas = assets.sheet(ATLAS_ASSET);
+    if (!atlas) {
+        printf("ERROR: Failed to load %s from %s!\n", ATLAS_ASSET, ASSET_ARCHIVE_PATH);
+        return;
+    }
+    for (int count = 10; count <= maxCount; count *= 10) {
+        Rng rng(1234);
+        // The player sits in the world's corner chunk, so the view starts
+        // at the world's origin like the old fixed screen.
+        Player player(TOP_WIDTH / 2, TOP_HEIGHT / 2);
+        WorldStreamer world(1234);
+        Asteroids field(count, rng);
+        field.explosionSound = explosionSound;
+        AsteroidExplosions explosions{explosionCapacityFor(count), rng};
+        for (int i = 0; i < count; i++) {
+            field.spawnAsteroid();
+            explosions.addExplosion(rng.below(TOP_WIDTH), rng.below(TOP_HEIGHT));
+        }
+        SpriteBatch batch(1 + count + explosionCapacityFor(count));
+        RenderSnapshot snapshot;
+        snapshot.reserve(1 + count + explosionCapacityFor(count), 0);
+        SnapshotRenderer renderer(atlas);
+        Citro2dBackend gpu;
+
+        int frames = iterationsFor(count);
+        double update = 0, collide = 0, explode = 0, draw = 0;
+        u32 audioAllocs = am.bank.allocationsTotal();
+        // Warm-up frame: the grid's scratch buffers grow to the asteroid count.
+        field.updateAsteroids(FRAME_DT);
+        field.stream(world, player.getPosition().first, player.getPosition().second);
+        field.asteroidsCollide(player, explosions, voices);
+        u32 crowded = field.crowdedCount();
+        AllocationWatch heapAllocs;
+        for (int frame = 0; frame < frames; frame++) {
+            update += elapsedUs([&] { field.updateAsteroids(FRAME_DT); });
+            // Refill what left the near chunks, as the wave scheduler would.
+            collide += elapsedUs([&] {
+                field.stream(world, player.getPosition().first, player.getPosition().second);
+                field.asteroidsCollide(player, explosions, voices);
+                while (field.count() < count) {
+                    field.spawnAsteroid();
+                }
+            });
+            explode += elapsedUs([&] { explosions.updateExplosions(); });
+            draw += elapsedUs([&] {
+                snapshot.clear();
+                player.snapshot(snapshot);
+                field.snapshotAsteroids(snapshot);
+                explosions.snapshotExplosions(snapshot);
+                renderer.draw(snapshot, batch, 1.0f);
+                batch.flush(gpu);
+            });
+        }
+        printf("asteroids,%d,%d,%.3f,%.3f,%.3f,%.3f,%.3f,%.1f,%lu,%llu,%lu\n", count, frames,
+               update / frames, collide / frames, explode / frames, draw / frames,
+               (update + collide + explode + draw) / frames, (double)(field.crowdedCount() - crowded) / frames,
+               (unsigned long)(am.bank.allocationsTotal() - audioAllocs),
+               (unsigned long long)heapAllocs.count(),
+               (unsigned long)batch.textureSwitchesLastFlush());
+    }
+}
+
+// Particle cost at a steady load: each frame tops the pool back up to the
+// target with one burst, then updates, snapshots and draws every particle.
+// The last row is the full PARTICLE_BUDGET, which has to fit a 60 fps frame.
+void benchParticles() {
+    AssetArchive assets;
+    assets.open(ASSET_ARCHIVE_PATH);
+    C2D_SpriteSheet atlas = assets.sheet(ATLAS_ASSET);
+    if (!atlas) {
+        printf("ERROR: Failed to load %s from %s!\n", ATLAS_ASSET, ASSET_ARCHIVE_PATH);
+        return;
+    }
+    SnapshotRenderer renderer(atlas);
+    Citro2dBackend gpu;
+    printf("suite,particles,frames,emit_us,update_us,snapshot_us,draw_us,frame_us,peak,dropped,heap_allocs\n");
+    for (int target = PARTICLE_BUDGET / 4; target <= PARTICLE_BUDGET; target *= 2) {
+        Particles particles(1234);
+        RenderSnapshot snapshot;
+        snapshot.reserve(0, PARTICLE_BUDGET);
+        ParticleBurst burst;
+        burst.x = TOP_WIDTH / 2;
+        burst.y = TOP_HEIGHT / 2;
+        burst.speedMax = 120;
+        particles.emit(burst, target);
+
+        int frames = 300;
+        double emit = 0, update = 0, snap = 0, draw = 0;
+        AllocationWatch heapAllocs;
+        for (int frame = 0; frame < frames; frame++) {
+            emit += elapsedUs([&] { particles.emit(burst, target - particles.count()); });
+            update += elapsedUs([&] { particles.update(FRAME_DT); });
+            snap += elapsedUs([&] {
+                snapshot.clear();
+                particles.snapshotParticles(snapshot);
+            });
+            draw += elapsedUs([&] { renderer.drawParticles(snapshot, gpu, 0.5f); });
+        }
+        printf("particles,%d,%d,%.3f,%.3f,%.3f,%.3f,%.3f,%d,%lu,%llu\n", target, frames,
+               emit / frames, update / frames, snap / frames, draw / frames,
+               (emit + update + snap + draw) / frames, particles.peakCount(),
+               (unsigned long)particles.droppedCount(), (unsigned long long)heapAllocs.count());
+    }
+}
+
+// Entity handles through a run of explosions. One starts every step and each
+// lasts the same number of steps, so at any time the live ones are the
+// newest, and every expiry swaps a newer explosion into the hole. Each step
+// every handle handed out so far is looked up: the live ones must find
+// distinct explosions, and the rest -1, even once their slots have gone to
+// newer explosions. Returns false if any lookup was wrong.
+bool benchHandles() {
+    const int steps = 2000, capacity = 32;
+    Rng rng(1234);
+    AsteroidExplosions explosions(capacity, rng);
+    std::vector<EntityHandle> handles;
+    handles.reserve(steps);
+    std::vector<int> seenAt(capacity, -1);
+    u64 lookups = 0, stale = 0, wrong = 0;
+    double lookupUs = 0;
+    AllocationWatch heapAllocs;
+    for (int step = 0; step < steps; step++) {
+        handles.push_back(explosions.addExplosion(step % TOP_WIDTH, TOP_HEIGHT / 2));
+        explosions.updateExplosions();
+        int live = explosions.count();
+        lookupUs += elapsedUs([&] {
+            for (int i = 0; i <= step; i++) {
+                int index = explosions.indexOf(handles[i]);
+                bool shouldLive = i > step - live;
+                if (index < 0) {
+                    stale++;
+                    if (shouldLive) wrong++;
+                } else if (!shouldLive || index >= live || seenAt[index] == step) {
+                    wrong++;
+                } else {
+                    seenAt[index] = step;
+                }
+            }
+        });
+        lookups += step + 1;
+    }
+    printf("suite,steps,lookups,lookup_ns,stale_lookups,wrong,heap_allocs\n");
+    printf("handles,%d,%llu,%.3f,%llu,%llu,%llu\n", steps, (unsigned long long)lookups, lookupUs * 1000.0 / lookups,
+           (unsigned long long)stale, (unsigned long long)wrong, (unsigned long long)heapAllocs.count());
+    return wrong == 0;
+}
+
+// The stress test from the game, single-threaded: the step cost is the time in
+// Game::step, as the simulation thread measures it, and the frame time is
+// drawing the step's snapshot to the stand-in renderer. Prints one row per level tried and the sustainable maximum, the
+// headline scaling number.
+void benchStress(int maxCount) {
+    AudioManager am;
+    VoiceManager voices(am);
+    AssetArchive assets;
+    assets.open(ASSET_ARCHIVE_PATH);
+    int explosionSound = assets.sound("explosion", am.bank);
+    C2D_SpriteSheet atlas = assets.sheet(ATLAS_ASSET);
+    if (!atlas) {
+        printf("ERROR: Failed to load %s from %s!\n", ATLAS_ASSET, ASSET_ARCHIVE_PATH);
+        return;
+    }
+    Game game(maxCount, 1234, voices, explosionSound);
+    StressTest stress(maxCount, 30);
+    game.enableStress(stress.targetCount());
+    RenderSnapshot snapshot;
+    snapshot.reserve(game.spriteCapacity(), PARTICLE_BUDGET);
+    SpriteBatch batch(game.spriteCapacity());
+    SnapshotRenderer renderer(atlas);
+    Citro2dBackend gpu;
+    double stepSeconds = FixedTimestep().stepSeconds();
+    InputFrame input;
+
+    printf("suite,target,live,frame_ms,step_ms\n");
+    int level = -1;
+    double levelFrameMs = 0, levelStepMs = 0;
+    int levelFrames = 0, levelLive = 0;
+    while (!stress.finished()) {
+        int target = stress.targetCount()->load();
+        if (target != level) {
+            if (levelFrames) {
+                printf("stress,%d,%d,%.3f,%.3f\n", level, levelLive / levelFrames, levelFrameMs / levelFrames,
+                       levelStepMs / levelFrames);
+            }
+            level = target;
+            levelFrameMs = levelStepMs = 0;
+            levelFrames = levelLive = 0;
+        }
+        double stepUs = elapsedUs([&] { game.step(input, stepSeconds); });
+        game.snapshot(snapshot);
+        double frameUs = elapsedUs([&] {
+            renderer.draw(snapshot, batch, 1.0f);
+            batch.flush(gpu);
+            renderer.drawParticles(snapshot, gpu, 1.0f);
+        });
+        stress.frameFinished(frameUs / 1000.0, stepUs / 1000.0, snapshot.asteroids);
+        levelFrameMs += frameUs / 1000.0;
+        levelStepMs += stepUs / 1000.0;
+        levelLive += snapshot.asteroids;
+        levelFrames++;
+    }
+    printf("stress,%d,%d,%.3f,%.3f\n", level, levelLive / levelFrames, levelFrameMs / levelFrames,
+           levelStepMs / levelFrames);
+    stress.report(stdout);
+}
+
+// Integrates NUMERIC_BODIES bodies under the same pseudo-random forces in
+// policy T, wrapping at the screen edges like the player does when `wrap` is
+// set. Returns the time taken in microseconds.
+const int NUMERIC_BODIES = 1024;
+const int NUMERIC_STEPS = 2000;
+
+template<typename T>
+double runBodies(const std::vector<float> & forces, bool wrap, std::vector<Body2D<T>> & bodies) {
+    bodies.clear();
+    for (int i = 0; i < NUMERIC_BODIES; i++) {
+        bodies.push_back(Body2D<T>(T((i * 37) % TOP_WIDTH), T((i * 91) % TOP_HEIGHT)));
+    }
+    std::vector<T> converted(forces.begin(), forces.end());
+    T dt = T(FixedTimestep().stepSeconds());
+    T width = T(TOP_WIDTH), height = T(TOP_HEIGHT);
+    return elapsedUs([&] {
+        for (int step = 0; step < NUMERIC_STEPS; step++) {
+            const T* force = &converted[(step % 64) * NUMERIC_BODIES * 2];
+            for (int i = 0; i < NUMERIC_BODIES; i++) {
+                bodies[i].applyForce(force[2 * i], force[2 * i + 1]);
+                bodies[i].integrate(dt);
+                if (wrap) {
+                    bodies[i].wrap(width, height);
+                }
+            }
+        }
+    });
+}
+
+// Cost per body-step with wrapping, and the worst position error against
+// double precision over the same run without wrapping. (Snapping to the far
+// edge on a wrap turns any tiny difference into a whole step's movement, so
+// errors are compared on unwrapped paths.)
+template<typename T>
+void benchPhysicsPolicy(const std::vector<float> & forces, const std::vector<Body2D<double>> & reference) {
+    std::vector<Body2D<T>> bodies;
+    double us = runBodies<T>(forces, true, bodies);
+    runBodies<T>(forces, false, bodies);
+    double worst = 0;
+    for (int i = 0; i < NUMERIC_BODIES; i++) {
+        worst = std::max(worst, std::fabs(Numeric<T>::toFloat(bodies[i].x) - reference[i].x));
+        worst = std::max(worst, std::fabs(Numeric<T>::toFloat(bodies[i].y) - reference[i].y));
+    }
+    printf("numeric,physics,%s,%d,%.3f,%.4f px\n", Numeric<T>::name(), NUMERIC_BODIES * NUMERIC_STEPS,
+           us * 1000.0 / (NUMERIC_BODIES * NUMERIC_STEPS), worst);
+}
+
+// Physics under each numeric policy, then the lookup-table trig against
+// libm over circle-pad-sized inputs. Errors are in pixels for physics and
+// degrees for the angles. Host timings only rank the options roughly; the
+// ARM11 has very different float and double costs.
+void benchNumeric() {
+    printf("suite,kind,variant,ops,ns_per_op,max_error\n");
+    Rng rng(1234);
+    std::vector<float> forces(64 * NUMERIC_BODIES * 2);
+    for (auto & force : forces) {
+        force = rng.between(-300, 301) / 100.0f;
+    }
+    std::vector<Body2D<double>> reference;
+    runBodies<double>(forces, false, reference);
+    benchPhysicsPolicy<double>(forces, reference);
+    benchPhysicsPolicy<float>(forces, reference);
+    benchPhysicsPolicy<Fixed16>(forces, reference);
+
+    const int samples = 1 << 20;
+    std::vector<float> xs(samples), ys(samples);
+    std::vector<Angle> angles(samples);
+    for (int i = 0; i < samples; i++) {
+        xs[i] = rng.between(-156, 157);
+        ys[i] = rng.between(-156, 157);
+        angles[i] = rng.next();
+    }
+    const double radiansToDegrees = 180.0 / M_PI;
+    volatile float sink = 0;
+    float sum = 0;
+    double libmUs = elapsedUs([&] {
+        for (int i = 0; i < samples; i++) sum += atan2f(ys[i], xs[i]);
+    });
+    double lutUs = elapsedUs([&] {
+        for (int i = 0; i < samples; i++) sum += lutAtan2(ys[i], xs[i]);
+    });
+    double worst = 0;
+    for (int i = 0; i < samples; i++) {
+        if (xs[i] == 0 && ys[i] == 0) continue;
+        double exact = std::atan2((double)ys[i], (double)xs[i]) * radiansToDegrees;
+        double approx = (s16)lutAtan2(ys[i], xs[i]) * (360.0 / 65536.0);
+        double error = std::fabs(exact - approx);
+        worst = std::max(worst, std::min(error, 360.0 - error));
+    }
+    printf("numeric,atan2,libm,%d,%.3f,0\n", samples, libmUs * 1000.0 / samples);
+    printf("numeric,atan2,table,%d,%.3f,%.4f deg\n", samples, lutUs * 1000.0 / samples, worst);
+
+    libmUs = elapsedUs([&] {
+        for (int i = 0; i < samples; i++) sum += sinf(angles[i] * ANGLE_TO_RADIANS) + cosf(angles[i] * ANGLE_TO_RADIANS);
+    });
+    lutUs = elapsedUs([&] {
+        for (int i = 0; i < samples; i++) sum += lutSin(angles[i]) + lutCos(angles[i]);
+    });
+    worst = 0;
+    for (int i = 0; i < samples; i++) {
+        double radians = angles[i] * (2 * M_PI / 65536.0);
+        worst = std::max(worst, std::fabs(std::sin(radians) - lutSin(angles[i])));
+        worst = std::max(worst, std::fabs(std::cos(radians) - lutCos(angles[i])));
+    }
+    sink = sum;
+    (void)sink;
+    printf("numeric,sincos,libm,%d,%.3f,0\n", samples, libmUs * 1000.0 / samples);
+    printf("numeric,sincos,table,%d,%.3f,%.4f\n", samples, lutUs * 1000.0 / samples, worst);
+}
+
+// Software mixer throughput: how many voices' worth of MIXER_CHUNK_FRAMES
+// chunks the SIMD kernels mix per millisecond, against the scalar loops,
+// for the explosion sound in stereo and a mono copy of it. realtime_voices
+// is how many voices one core could keep fed. Also checks that the SIMD
+// and scalar outputs are identical.
+void benchMixer() {
+    AudioManager am;
+    AssetArchive assets;
+    assets.open(ASSET_ARCHIVE_PATH);
+    const Sound* sound = am.bank.get(assets.sound("explosion", am.bank));
+    if (!sound || sound->wav.channels != 2 || sound->wav.bitsPerSample != 16) {
+        printf("ERROR: the mixer benchmark needs the explosion sound as 16-bit stereo\n");
+        return;
+    }
+    const s16* stereo = (const s16*)sound->wav.data;
+    u32 frames = sound->nsamples;
+    std::vector<s16> mono(frames);
+    for (u32 i = 0; i < frames; i++) {
+        mono[i] = stereo[2 * i];
+    }
+    const int chunks = frames / MIXER_CHUNK_FRAMES;
+    const double chunkMs = 1000.0 * MIXER_CHUNK_FRAMES / MIXER_SAMPLE_RATE;
+    std::vector<s16> out(MIXER_CHUNK_FRAMES * 2), reference(MIXER_CHUNK_FRAMES * 2);
+
+    printf("suite,voices,layout,chunks,simd_us_per_chunk,scalar_us_per_chunk,voices_per_ms,speedup,realtime_voices,bit_exact\n");
+    for (int layout = 2; layout >= 1; layout--) {
+        const s16* data = layout == 2 ? stereo : mono.data();
+        for (int voices = 1; voices <= MIXER_MAX_VOICES; voices *= 4) {
+            // Voices are staggered so they don't all read the same samples.
+            auto offset = [&](int v) { return (u32)(v * 997 % (frames / 2)); };
+            SoftwareMixer mixer(0);
+            for (int v = 0; v < voices; v++) {
+                u32 start = offset(v);
+                mixer.play(data + start * layout, frames - start, layout, MIXER_SAMPLE_RATE, 0.5f, (v % 3) - 1.0f);
+            }
+            int mixed = std::min<int>(chunks, (frames - offset(voices - 1)) / MIXER_CHUNK_FRAMES);
+            double simd = elapsedUs([&] {
+                for (int c = 0; c < mixed; c++) {
+                    mixer.mix(out.data(), MIXER_CHUNK_FRAMES);
+                }
+            });
+
+            float left, right;
+            bool exact = true;
+            double scalar = 0;
+            for (int c = 0; c < mixed; c++) {
+                std::fill(reference.begin(), reference.end(), 0);
+                std::fill(out.begin(), out.end(), 0);
+                scalar += elapsedUs([&] {
+                    for (int v = 0; v < voices; v++) {
+                        panGains(0.5f, (v % 3) - 1.0f, left, right);
+                        const s16* in = data + (offset(v) + c * MIXER_CHUNK_FRAMES) * layout;
+                        if (layout == 2) {
+                            mixStereoPcm16Scalar(reference.data(), in, MIXER_CHUNK_FRAMES, toQ15(left), toQ15(right));
+                        } else {
+                            mixMonoPcm16Scalar(reference.data(), in, MIXER_CHUNK_FRAMES, toQ15(left), toQ15(right));
+                        }
+                    }
+                });
+                for (int v = 0; v < voices; v++) {
+                    panGains(0.5f, (v % 3) - 1.0f, left, right);
+                    const s16* in = data + (offset(v) + c * MIXER_CHUNK_FRAMES) * layout;
+                    if (layout == 2) {
+                        mixStereoPcm16(out.data(), in, MIXER_CHUNK_FRAMES, toQ15(left), toQ15(right));
+                    } else {
+                        mixMonoPcm16(out.data(), in, MIXER_CHUNK_FRAMES, toQ15(left), toQ15(right));
+                    }
+                }
+                exact = exact && out == reference;
+            }
+            double voicesPerMs = voices * mixed / (simd / 1000.0);
+            printf("mixer,%d,%s,%d,%.3f,%.3f,%.0f,%.2f,%.0f,%s\n", voices, layout == 2 ? "stereo" : "mono", mixed,
+                   simd / mixed, scalar / mixed, voicesPerMs, scalar / simd, voicesPerMs * chunkMs, exact ? "yes" : "no");
+        }
+    }
+}
+
+// Player against asteroid tests for random poses, in two spreads: "close",
+// within 40 px, where the old 17.5 px hit circle could matter and many
+// pairs reach the masks; and "screen", anywhere on screen around the
+// player, which is what the game sees without the grid. Compares that
+// circle alone, the bounding circles alone, and the bounding circles
+// followed by the pixel masks, which is what the game does. A mask is only
+// looked up once the circles overlap, so misses cost about the same as the
+// old circle and the extra cost scales with how many pairs are close.
+// Rows report ns per test and how many were hits.
+void benchCollision() {
+    const int tests = 200000;
+    const float oldHitRadius = 17.5f;
+    struct Pose {
+        float dx, dy;
+        Angle heading, spin;
+        int image;
+    };
+    u64 shapeStart = svcGetSystemTick();
+    const CollisionShapes & shapes = collisionShapes();
+    float buildMs = (svcGetSystemTick() - shapeStart) / (SYSCLOCK_ARM11 / 1000.0f);
+    const CollisionShape & playerShape = shapes.shape(ATLAS_ROCKET_OFF);
+    MemoryUsage usage = memoryUsage(MEM_COLLISION, MEM_HEAP);
+    printf("suite,spread,test,tests,ns_per_test,hits,build_ms,mask_bytes\n");
+
+    const struct {
+        const char* name;
+        int halfWidth, halfHeight;
+    } spreads[] = {{"close", 40, 40}, {"screen", TOP_WIDTH / 2, TOP_HEIGHT / 2}};
+    for (const auto & spread : spreads) {
+        Rng rng(1234);
+        std::vector<Pose> poses(tests);
+        for (Pose & pose : poses) {
+            pose.dx = rng.between(-spread.halfWidth, spread.halfWidth);
+            pose.dy = rng.between(-spread.halfHeight, spread.halfHeight);
+            pose.heading = (Angle)rng.below(65536);
+            pose.spin = (Angle)rng.below(65536);
+            pose.image = ASTEROID_FIRST_IMAGE + rng.below(ASTEROID_IMAGE_COUNT);
+        }
+
+        int circleHits = 0, boundHits = 0, maskHits = 0;
+        double circle = elapsedUs([&] {
+            for (const Pose & pose : poses) {
+                circleHits += pose.dx * pose.dx + pose.dy * pose.dy < oldHitRadius * oldHitRadius;
+            }
+        });
+        auto withinBounds = [&](const Pose & pose) {
+            float hitDist = playerShape.radius() + shapes.shape(pose.image).radius();
+            return pose.dx * pose.dx + pose.dy * pose.dy < hitDist * hitDist;
+        };
+        double bound = elapsedUs([&] {
+            for (const Pose & pose : poses) {
+                boundHits += withinBounds(pose);
+            }
+        });
+        double mask = elapsedUs([&] {
+            for (const Pose & pose : poses) {
+                maskHits += withinBounds(pose) && masksOverlap(playerShape.at(pose.heading), 0, 0,
+                                                               shapes.shape(pose.image).at(pose.spin), pose.dx, pose.dy);
+            }
+        });
+        printf("collision,%s,old_circle,%d,%.2f,%d,,\n", spread.name, tests, circle * 1000 / tests, circleHits);
+        printf("collision,%s,bounds,%d,%.2f,%d,,\n", spread.name, tests, bound * 1000 / tests, boundHits);
+        printf("collision,%s,bounds_then_mask,%d,%.2f,%d,%.2f,%lld\n", spread.name, tests, mask * 1000 / tests, maskHits,
+               buildMs, (long long)usage.live);
+    }
+}
+
+// Cost of each startup stage that touches assets, averaged over several cold
+// runs: reading and indexing the archive, turning the atlas into a sprite
+// sheet, registering the explosion sound, and decoding it on its first hit.
+void benchStartup(int runs) {
+    AudioManager am;
+    double openMs = 0, atlasMs = 0, registerMs = 0, firstHitMs = 0;
+    size_t bytes = 0;
+    for (int run = 0; run < runs; run++) {
+        SoundBank bank;
+        AssetArchive assets;
+        openMs += elapsedUs([&] { assets.open(ASSET_ARCHIVE_PATH); }) / 1000.0;
+        atlasMs += elapsedUs([&] { assets.sheet(ATLAS_ASSET); }) / 1000.0;
+        int sound = -1;
+        registerMs += elapsedUs([&] { sound = assets.sound("explosion", bank); }) / 1000.0;
+        firstHitMs += elapsedUs([&] { bank.materialize(sound); }) / 1000.0;
+        bytes = assets.sizeBytes();
+    }
+    printf("suite,runs,archive_bytes,open_ms,atlas_ms,sound_register_ms,first_hit_ms,total_ms\n");
+    printf("startup,%d,%zu,%.3f,%.3f,%.3f,%.3f,%.3f\n", runs, bytes, openMs / runs, atlasMs / runs,
+           registerMs / runs, firstHitMs / runs, (openMs + atlasMs + registerMs + firstHitMs) / runs);
+}
+
+// Plays steps of hostScriptedInput from a fixed seed, as the host build does,
+// and saves the session as a replay, so the replay and render suites have a
+// run with steering, boosting and fuel burns in it when no file is given.
+#define SCRIPTED_REPLAY_PATH "scripted.rpl"
+#define SCRIPTED_REPLAY_STEPS 3600
+#define SCRIPTED_REPLAY_SEED 1234
+
+bool recordScripted(const char* path, u32 steps) {
+    AudioManager am;
+    VoiceManager voices(am);
+    AssetArchive assets;
+    assets.open(ASSET_ARCHIVE_PATH);
+    int explosionSound = assets.sound("explosion", am.bank);
+    Game game(WAVE_MAX_ASTEROIDS, SCRIPTED_REPLAY_SEED, voices, explosionSound);
+    InputRecorder recorder(SCRIPTED_REPLAY_SEED, WAVE_MAX_ASTEROIDS);
+    collisionShapes();
+
+    const double dt = FixedTimestep().stepSeconds();
+    InputFrame input;
+    u32 held = 0;
+    for (u32 step = 0; step < steps && !game.over(); step++) {
+        u32 next;
+        hostScriptedInput(step, &next, &input.dx, &input.dy);
+        input.kDown = next & ~held;
+        input.kUp = held & ~next;
+        input.kHeld = held = next;
+        recorder.record(input);
+        game.step(input, dt);
+    }
+    return recorder.save(path, game.hashState());
+}
+
+// Runs a recorded session as fast as possible, single-threaded, and checks
+// that it ends in the recorded state. Returns false on a hash mismatch.
+bool benchReplay(const char* path) {
+    InputReplay replay;
+    if (!replay.load(path)) {
+        return false;
+    }
+    AudioManager am;
+    VoiceManager voices(am);
+    AssetArchive assets;
+    assets.open(ASSET_ARCHIVE_PATH);
+    int explosionSound = assets.sound("explosion", am.bank);
+    Game game(replay.asteroidLimit(), replay.seed(), voices, explosionSound);
+    RenderSnapshot snapshot;
+    snapshot.reserve(game.spriteCapacity(), PARTICLE_BUDGET);
+    // Built at startup in the game, so not part of any step.
+    collisionShapes();
+
+    // Same step length as the game, which is a whole number of system ticks
+    // rather than exactly FRAME_DT.
+    const double dt = FixedTimestep().stepSeconds();
+    InputFrame input;
+    double total = 0, worst = 0;
+    AllocationWatch heapAllocs;
+    while (!game.over() && replay.next(input)) {
+        double us = elapsedUs([&] {
+            game.step(input, dt);
+            game.snapshot(snapshot);
+        });
+        total += us;
+        worst = std::max(worst, us);
+    }
+    u64 hash = game.hashState();
+    bool match = !replay.expectedHash() || hash == replay.expectedHash();
+    printf("suite,steps,step_us,worst_step_us,heap_allocs,hash,expected_hash,match\n");
+    printf("replay,%llu,%.3f,%.3f,%llu,%016llx,%016llx,%s\n", (unsigned long long)game.steps,
+           game.steps ? total / game.steps : 0.0, worst, (unsigned long long)heapAllocs.count(),
+           (unsigned long long)hash, (unsigned long long)replay.expectedHash(), match ? "yes" : "no");
+    return match;
+}
+
+// Plays a replay and renders every step twice: once through the headless
+// backend, which counts the commands and checksums them, and once through
+// citro2d (the stand-in on the host). Building the batch (culling included)
+// is timed apart from sorting and submitting it. The checksum depends only
+// on the replay and the renderer, so it catches rendering changes between
+// builds.
+bool benchRender(const char* path) {
+    InputReplay replay;
+    if (!replay.load(path)) {
+        return false;
+    }
+    AudioManager am;
+    VoiceManager voices(am);
+    AssetArchive assets;
+    assets.open(ASSET_ARCHIVE_PATH);
+    int explosionSound = assets.sound("explosion", am.bank);
+    C2D_SpriteSheet atlas = assets.sheet(ATLAS_ASSET);
+    if (!atlas) {
+        printf("ERROR: Failed to load %s from %s!\n", ATLAS_ASSET, ASSET_ARCHIVE_PATH);
+        return false;
+    }
+    Game game(replay.asteroidLimit(), replay.seed(), voices, explosionSound);
+    RenderSnapshot snapshot;
+    snapshot.reserve(game.spriteCapacity(), PARTICLE_BUDGET);
+    SpriteBatch batch(game.spriteCapacity());
+    SnapshotRenderer renderer(atlas), gpuRenderer(atlas);
+    HeadlessBackend headless;
+    Citro2dBackend gpu;
+    collisionShapes();
+
+    const double dt = FixedTimestep().stepSeconds();
+    InputFrame input;
+    double build = 0, headlessFlush = 0, gpuDraw = 0;
+    AllocationWatch heapAllocs;
+    while (!game.over() && replay.next(input)) {
+        game.step(input, dt);
+        game.snapshot(snapshot);
+        build += elapsedUs([&] { renderer.draw(snapshot, batch, 1.0f); });
+        headlessFlush += elapsedUs([&] {
+            batch.flush(headless);
+            renderer.drawParticles(snapshot, headless, 1.0f);
+        });
+        gpuDraw += elapsedUs([&] {
+            gpuRenderer.draw(snapshot, batch, 1.0f);
+            batch.flush(gpu);
+            gpuRenderer.drawParticles(snapshot, gpu, 1.0f);
+        });
+    }
+    double steps = std::max<u64>(game.steps, 1);
+    printf("suite,steps,sprites,culled_sprites,particles,culled_particles,images,rects,build_us,headless_flush_us,"
+           "citro2d_frame_us,heap_allocs,checksum\n");
+    printf("render,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%.3f,%.3f,%.3f,%llu,%016llx\n", (unsigned long long)game.steps,
+           (unsigned long long)renderer.spriteCount(), (unsigned long long)renderer.culledSprites(),
+           (unsigned long long)renderer.particleCount(), (unsigned long long)renderer.culledParticles(),
+           (unsigned long long)headless.imageCount(), (unsigned long long)headless.rectCount(), build / steps,
+           headlessFlush / steps, gpuDraw / steps, (unsigned long long)heapAllocs.count(),
+           (unsigned long long)headless.checksum());
+    return true;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    std::string suite = argc > 1 ? argv[1] : "all";
+    if (suite == "replay") {
+        if (argc > 2) {
+            return benchReplay(argv[2]) ? 0 : 1;
+        }
+        return recordScripted(SCRIPTED_REPLAY_PATH, SCRIPTED_REPLAY_STEPS) && benchReplay(SCRIPTED_REPLAY_PATH) ? 0 : 1;
+    }
+    if (suite == "render") {
+        if (argc > 2) {
+            return benchRender(argv[2]) ? 0 : 1;
+        }
+        return recordScripted(SCRIPTED_REPLAY_PATH, SCRIPTED_REPLAY_STEPS) && benchRender(SCRIPTED_REPLAY_PATH) ? 0 : 1;
+    }
+    int maxCount = argc > 2 ? std::atoi(argv[2]) : 100000;
+
+    if (suite == "all" || suite == "startup") {
+        benchStartup(20);
+    }
+    if (suite == "all" || suite == "asteroids") {
+        benchAsteroids(maxCount);
+    }
+    if (suite == "all" || suite == "particles") {
+        benchParticles();
+    }
+    if (suite == "all" || suite == "numeric") {
+        benchNumeric();
+    }
+    if (suite == "all" || suite == "mixer") {
+        benchMixer();
+    }
+    if (suite == "all" || suite == "collision") {
+        benchCollision();
+    }
+    bool ok = true;
+    if (suite == "all" || suite == "handles") {
+        ok = benchHandles() && ok;
+    }
+    if (suite == "all" || suite == "stress") {
+        benchStress(maxCount);
+    }
+    return ok ? 0 : 1;
+}
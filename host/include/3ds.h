@@ -0,0 +1,150 @@
+// Host stand-in for libctru's <3ds.h>.
+// Only the subset of the API the game touches is declared here; the
+// implementations live in host/src/ctru_stub.cpp and behave like a 3DS with
+// no buttons pressed, a silent DSP and a wall-clock driven system tick.
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+typedef int8_t s8;
+typedef int16_t s16;
+typedef int32_t s32;
+typedef int64_t s64;
+typedef s32 Result;
+typedef u32 Handle;
+
+#define U64_MAX UINT64_MAX
+#define BIT(n) (1U<<(n))
+#define R_SUCCEEDED(res) ((res)>=0)
+#define R_FAILED(res) ((res)<0)
+
+#define SYSCLOCK_ARM11 268111856ULL
+
+#include <3ds/os.h>
+
+// ---------------------------------------------------------------- gfx / apt
+typedef enum { GFX_TOP = 0, GFX_BOTTOM = 1 } gfxScreen_t;
+typedef enum { GFX_LEFT = 0, GFX_RIGHT = 1 } gfx3dSide_t;
+
+typedef struct PrintConsole PrintConsole;
+
+void gfxInitDefault(void);
+void gfxExit(void);
+PrintConsole* consoleInit(gfxScreen_t screen, PrintConsole* console);
+void consoleClear(void);
+bool aptMainLoop(void);
+Result APT_CheckNew3DS(bool* out);
+
+Result romfsInit(void);
+Result romfsExit(void);
+
+// ---------------------------------------------------------------------- hid
+enum {
+    KEY_A       = BIT(0),
+    KEY_B       = BIT(1),
+    KEY_SELECT  = BIT(2),
+    KEY_START   = BIT(3),
+    KEY_DRIGHT  = BIT(4),
+    KEY_DLEFT   = BIT(5),
+    KEY_DUP     = BIT(6),
+    KEY_DDOWN   = BIT(7),
+    KEY_R       = BIT(8),
+    KEY_L       = BIT(9),
+    KEY_X       = BIT(10),
+    KEY_Y       = BIT(11),
+};
+
+typedef struct {
+    s16 dx;
+    s16 dy;
+} circlePosition;
+
+void hidScanInput(void);
+u32 hidKeysDown(void);
+u32 hidKeysHeld(void);
+u32 hidKeysUp(void);
+void hidCircleRead(circlePosition* pos);
+
+// ----------------------------------------------------------------- svc/mem
+u64 svcGetSystemTick(void);
+void svcSleepThread(s64 ns);
+
+#define CUR_THREAD_HANDLE 0xFFFF8000
+Result svcGetThreadPriority(s32* out, Handle handle);
+
+// ------------------------------------------------------------------ threads
+// Backed by std::thread; priority and core are accepted and ignored.
+typedef struct Thread_tag* Thread;
+typedef void (*ThreadFunc)(void* arg);
+
+Thread threadCreate(ThreadFunc entrypoint, void* arg, size_t stack_size, int prio, int core_id, bool detached);
+Result threadJoin(Thread thread, u64 timeout_ns);
+void threadFree(Thread thread);
+
+void* linearAlloc(size_t size);
+void linearFree(void* mem);
+u32 linearSpaceFree(void);
+
+// --------------------------------------------------------------------- ndsp
+typedef enum {
+    NDSP_OUTPUT_MONO = 0,
+    NDSP_OUTPUT_STEREO = 1,
+    NDSP_OUTPUT_SURROUND = 2,
+} ndspOutputMode;
+
+typedef enum {
+    NDSP_INTERP_POLYPHASE = 0,
+    NDSP_INTERP_LINEAR = 1,
+    NDSP_INTERP_NONE = 2,
+} ndspInterpType;
+
+enum {
+    NDSP_FORMAT_MONO_PCM8    = 1,
+    NDSP_FORMAT_MONO_PCM16   = 5,
+    NDSP_FORMAT_STEREO_PCM8  = 2,
+    NDSP_FORMAT_STEREO_PCM16 = 6,
+};
+
+enum {
+    NDSP_WBUF_FREE = 0,
+    NDSP_WBUF_QUEUED,
+    NDSP_WBUF_PLAYING,
+    NDSP_WBUF_DONE,
+};
+
+typedef struct ndspWaveBuf ndspWaveBuf;
+struct ndspWaveBuf {
+    union {
+        s8* data_pcm8;
+        s16* data_pcm16;
+        u8* data_adpcm;
+        const void* data_vaddr;
+    };
+    u32 nsamples;
+    void* adpcm_data;
+    u32 offset;
+    bool looping;
+    volatile u8 status;
+    u16 sequence_id;
+    ndspWaveBuf* next;
+};
+
+Result ndspInit(void);
+void ndspExit(void);
+void ndspSetOutputMode(ndspOutputMode mode);
+void ndspChnReset(int id);
+void ndspChnWaveBufClear(int id);
+void ndspChnWaveBufAdd(int id, ndspWaveBuf* buf);
+void ndspChnSetInterp(int id, ndspInterpType type);
+void ndspChnSetRate(int id, float rate);
+void ndspChnSetFormat(int id, u16 format);
+void ndspChnSetMix(int id, float mix[12]);
+bool ndspChnIsPlaying(int id);
+Result DSP_FlushDataCache(const void* address, u32 size);
@@ -0,0 +1,7 @@
+// Host stand-in for libctru's <3ds/os.h>.
+#pragma once
+
+#include <stdint.h>
+
+// Milliseconds since the epoch, like the 3DS RTC-backed osGetTime.
+uint64_t osGetTime(void);
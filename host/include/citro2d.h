@@ -0,0 +1,145 @@
+// Host stand-in for <citro2d.h>.
+// Sprite helpers are inline exactly like upstream so the game's sprite math
+// runs unchanged; draw calls are counted by host/src/citro2d_stub.cpp.
+#pragma once
+
+#include <citro3d.h>
+#include <tex3ds.h>
+
+#define C2D_DEFAULT_MAX_OBJECTS 4096
+
+typedef struct C2D_SpriteSheet_s* C2D_SpriteSheet;
+typedef struct C2D_TextBuf_s* C2D_TextBuf;
+typedef struct C2D_Font_s* C2D_Font;
+
+typedef struct {
+    C3D_Tex* tex;
+    const Tex3DS_SubTexture* subtex;
+} C2D_Image;
+
+typedef struct {
+    struct {
+        float x, y, w, h;
+    } pos;
+    struct {
+        float x, y;
+    } center;
+    float depth;
+    float angle;
+} C2D_DrawParams;
+
+typedef struct {
+    C2D_Image image;
+    C2D_DrawParams params;
+} C2D_Sprite;
+
+typedef struct {
+    C2D_TextBuf buf;
+    size_t begin;
+    size_t end;
+    float width;
+    u32 lines;
+    u32 words;
+    C2D_Font font;
+} C2D_Text;
+
+typedef struct C2D_ImageTint_s C2D_ImageTint;
+
+enum {
+    C2D_AtBaseline = BIT(0),
+    C2D_WithColor  = BIT(1),
+    C2D_AlignLeft  = 0 << 2,
+    C2D_AlignRight = 1 << 2,
+    C2D_AlignCenter = 2 << 2,
+};
+
+static inline u32 C2D_Color32(u8 r, u8 g, u8 b, u8 a) {
+    return r | (g << (u32)8) | (b << (u32)16) | (a << (u32)24);
+}
+
+static inline float C2D_Clamp(float x, float min, float max) {
+    return x <= min ? min : x >= max ? max : x;
+}
+
+static inline u8 C2D_FloatToU8(float x) {
+    return (u8)(255.0f*C2D_Clamp(x, 0.0f, 1.0f)+0.5f);
+}
+
+static inline u32 C2D_Color32f(float r, float g, float b, float a) {
+    return C2D_Color32(C2D_FloatToU8(r), C2D_FloatToU8(g), C2D_FloatToU8(b), C2D_FloatToU8(a));
+}
+
+bool C2D_Init(size_t maxObjects);
+void C2D_Fini(void);
+void C2D_Prepare(void);
+C3D_RenderTarget* C2D_CreateScreenTarget(gfxScreen_t screen, gfx3dSide_t side);
+void C2D_TargetClear(C3D_RenderTarget* target, u32 color);
+void C2D_SceneBegin(C3D_RenderTarget* target);
+
+C2D_SpriteSheet C2D_SpriteSheetLoad(const char* filename);
+C2D_SpriteSheet C2D_SpriteSheetLoadFromMem(const void* data, size_t size);
+void C2D_SpriteSheetFree(C2D_SpriteSheet sheet);
+size_t C2D_SpriteSheetCount(C2D_SpriteSheet sheet);
+C2D_Image C2D_SpriteSheetGetImage(C2D_SpriteSheet sheet, size_t index);
+
+bool C2D_DrawImage(C2D_Image img, const C2D_DrawParams* params, const C2D_ImageTint* tint);
+bool C2D_DrawRectSolid(float x, float y, float z, float w, float h, u32 clr);
+
+C2D_TextBuf C2D_TextBufNew(size_t maxGlyphs);
+void C2D_TextBufDelete(C2D_TextBuf buf);
+void C2D_TextBufClear(C2D_TextBuf buf);
+const char* C2D_TextParse(C2D_Text* text, C2D_TextBuf buf, const char* str);
+void C2D_TextOptimize(const C2D_Text* text);
+void C2D_TextGetDimensions(const C2D_Text* text, float scaleX, float scaleY, float* outWidth, float* outHeight);
+void C2D_DrawText(const C2D_Text* text, u32 flags, float x, float y, float z, float scaleX, float scaleY, ...);
+
+static inline void C2D_SpriteFromImage(C2D_Sprite* sprite, C2D_Image image) {
+    sprite->image = image;
+    sprite->params.pos.x = 0.0f;
+    sprite->params.pos.y = 0.0f;
+    sprite->params.pos.w = image.subtex->width;
+    sprite->params.pos.h = image.subtex->height;
+    sprite->params.center.x = 0.0f;
+    sprite->params.center.y = 0.0f;
+    sprite->params.angle = 0.0f;
+    sprite->params.depth = 0.0f;
+}
+
+static inline void C2D_SpriteFromSheet(C2D_Sprite* sprite, C2D_SpriteSheet sheet, size_t index) {
+    C2D_SpriteFromImage(sprite, C2D_SpriteSheetGetImage(sheet, index));
+}
+
+static inline void C2D_SpriteSetScale(C2D_Sprite* sprite, float x, float y) {
+    float oldCenterX = sprite->params.center.x / sprite->params.pos.w;
+    float oldCenterY = sprite->params.center.y / sprite->params.pos.h;
+    sprite->params.pos.w = x*sprite->image.subtex->width;
+    sprite->params.pos.h = y*sprite->image.subtex->height;
+    sprite->params.center.x = fabsf(oldCenterX*sprite->params.pos.w);
+    sprite->params.center.y = fabsf(oldCenterY*sprite->params.pos.h);
+}
+
+static inline void C2D_SpriteSetCenter(C2D_Sprite* sprite, float x, float y) {
+    sprite->params.center.x = x*sprite->params.pos.w;
+    sprite->params.center.y = y*sprite->params.pos.h;
+}
+
+static inline void C2D_SpriteSetPos(C2D_Sprite* sprite, float x, float y) {
+    sprite->params.pos.x = x;
+    sprite->params.pos.y = y;
+}
+
+static inline void C2D_SpriteSetRotation(C2D_Sprite* sprite, float radians) {
+    sprite->params.angle = radians;
+}
+
+static inline void C2D_SpriteSetRotationDegrees(C2D_Sprite* sprite, float degrees) {
+    C2D_SpriteSetRotation(sprite, C3D_AngleFromDegrees(degrees));
+}
+
+static inline void C2D_SpriteSetDepth(C2D_Sprite* sprite, float depth) {
+    sprite->params.depth = depth;
+}
+
+static inline bool C2D_DrawSprite(const C2D_Sprite* sprite) {
+    return C2D_DrawImage(sprite->image, &sprite->params, NULL);
+}
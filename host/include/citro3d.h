@@ -0,0 +1,47 @@
+// Host stand-in for <citro3d.h>. Frames are counted, nothing is rendered.
+#pragma once
+
+#include <3ds.h>
+#include <math.h>
+
+#define C3D_DEFAULT_CMDBUF_SIZE 0x40000
+#define C3D_FRAME_SYNCDRAW BIT(0)
+#define C3D_FRAME_NONBLOCK BIT(1)
+
+#define M_TAU (2*M_PI)
+#define C3D_AngleFromDegrees(_angle) ((_angle)*M_TAU/360.0f)
+
+typedef enum {
+    GPU_RGBA8 = 0x0,
+    GPU_RGB8 = 0x1,
+    GPU_RGBA5551 = 0x2,
+    GPU_RGB565 = 0x3,
+    GPU_RGBA4 = 0x4,
+    GPU_LA8 = 0x5,
+    GPU_HILO8 = 0x6,
+    GPU_L8 = 0x7,
+    GPU_A8 = 0x8,
+    GPU_LA4 = 0x9,
+    GPU_L4 = 0xA,
+    GPU_A4 = 0xB,
+    GPU_ETC1 = 0xC,
+    GPU_ETC1A4 = 0xD,
+} GPU_TEXCOLOR;
+
+typedef struct {
+    void* data;
+    GPU_TEXCOLOR fmt;
+    size_t size;
+    u16 width;
+    u16 height;
+} C3D_Tex;
+
+typedef struct C3D_RenderTarget_tag {
+    gfxScreen_t screen;
+    gfx3dSide_t side;
+} C3D_RenderTarget;
+
+bool C3D_Init(size_t cmdBufSize);
+void C3D_Fini(void);
+bool C3D_FrameBegin(u8 flags);
+void C3D_FrameEnd(u8 flags);
@@ -0,0 +1,37 @@
+// Controls and counters that only exist on the host build.
+// Game code only touches it from main()'s host-only blocks; the benchmarks
+// use it to script input and read back what the stubs were asked to do.
+#pragma once
+
+#include <3ds.h>
+
+typedef struct {
+    u64 frames;
+    u64 drawCalls;
+    u64 textureBinds;
+    u64 rectDraws;
+    u64 textDraws;
+    u64 waveBufsQueued;
+    u64 linearBytesLive;
+    u64 linearAllocs;
+} HostStats;
+
+// Number of aptMainLoop iterations before the host "closes" the app.
+// Defaults to $ROCKET_HOST_FRAMES or 300.
+void hostSetFrameLimit(u64 frames);
+
+// Starts counting aptMainLoop iterations towards the limit from zero again.
+// The game calls it when loading is done, so the limit counts game frames
+// and an unthrottled loading screen can't use them up.
+void hostRestartFrameCount(void);
+
+// Buttons held and circle pad position reported by the next hidScanInput.
+void hostSetInput(u32 held, s16 dx, s16 dy);
+
+// Scripted play for host runs and benchmarks: a fixed 12-second loop of
+// steering round the compass, booster bursts, fuel burns and idling. The
+// same frame always gives the same input.
+void hostScriptedInput(u64 frame, u32* held, s16* dx, s16* dy);
+
+const HostStats* hostGetStats(void);
+void hostResetStats(void);
@@ -0,0 +1,13 @@
+// Host stand-in for <tex3ds.h>.
+#pragma once
+
+#include <citro3d.h>
+
+typedef struct {
+    u16 width;
+    u16 height;
+    float left;
+    float top;
+    float right;
+    float bottom;
+} Tex3DS_SubTexture;
@@ -0,0 +1,259 @@
+// Host implementation of the citro2d/citro3d subset. Sprite sheets are read
+// from the real .t3x files and their texture data is decompressed into
+// linear memory, so image counts, sizes and load times resemble the device,
+// but nothing is drawn; draws are only counted.
+#include <citro2d.h>
+#include "stub_internal.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <string>
+#include <vector>
+
+struct C2D_SpriteSheet_s {
+    C3D_Tex tex;
+    std::vector<Tex3DS_SubTexture> subtextures;
+};
+
+struct C2D_TextBuf_s {
+    size_t maxGlyphs;
+    size_t used;
+};
+
+namespace {
+
+C3D_RenderTarget targets[2] = {{GFX_TOP, GFX_LEFT}, {GFX_BOTTOM, GFX_LEFT}};
+const C3D_Tex* lastTex = nullptr;
+
+// C3D_FRAME_SYNCDRAW waits for vblank on hardware. The host does the same at
+// 60 Hz of host clock unless $ROCKET_HOST_NOVSYNC is set, so fixed-timestep
+// code sees realistic frame times.
+bool vsyncEnabled() {
+    static bool enabled = std::getenv("ROCKET_HOST_NOVSYNC") == nullptr;
+    return enabled;
+}
+std::chrono::steady_clock::time_point nextVBlank = std::chrono::steady_clock::now();
+
+void waitForVBlank() {
+    const auto frame = std::chrono::nanoseconds((long long)(1000000000LL / 60 / hostClockSpeed()));
+    // Like the real vblank, the ticks stay on a fixed grid: a late frame
+    // waits for the next one rather than starting a new grid from now.
+    auto now = std::chrono::steady_clock::now();
+    if (now - nextVBlank > frame * 60) {
+        nextVBlank = now;
+    }
+    while (nextVBlank <= now) {
+        nextVBlank += frame;
+    }
+    std::this_thread::sleep_until(nextVBlank);
+}
+
+u16 readU16(const u8* data) {
+    return data[0] | (data[1] << 8);
+}
+
+// Same LZ11 stream Tex3DS writes and citro2d decodes on the device.
+bool lz11Decompress(const u8* in, size_t inSize, u8* out, size_t outSize) {
+    size_t ip = 0, op = 0;
+    while (op < outSize) {
+        if (ip >= inSize) return false;
+        u8 flags = in[ip++];
+        for (int bit = 7; bit >= 0 && op < outSize; bit--) {
+            if (!(flags & (1 << bit))) {
+                if (ip >= inSize) return false;
+                out[op++] = in[ip++];
+                continue;
+            }
+            if (ip + 1 >= inSize) return false;
+            u8 b0 = in[ip++];
+            size_t len, disp;
+            if ((b0 >> 4) == 0) {
+                if (ip + 1 >= inSize) return false;
+                u8 b1 = in[ip++], b2 = in[ip++];
+                len = (((b0 & 0xF) << 4) | (b1 >> 4)) + 0x11;
+                disp = (((b1 & 0xF) << 8) | b2) + 1;
+            } else if ((b0 >> 4) == 1) {
+                if (ip + 2 >= inSize) return false;
+                u8 b1 = in[ip++], b2 = in[ip++], b3 = in[ip++];
+                len = (((b0 & 0xF) << 12) | (b1 << 4) | (b2 >> 4)) + 0x111;
+                disp = (((b2 & 0xF) << 8) | b3) + 1;
+            } else {
+                u8 b1 = in[ip++];
+                len = (b0 >> 4) + 1;
+                disp = (((b0 & 0xF) << 8) | b1) + 1;
+            }
+            if (disp > op) return false;
+            for (size_t i = 0; i < len && op < outSize; i++, op++) {
+                out[op] = out[op - disp];
+            }
+        }
+    }
+    return true;
+}
+
+void bindTexture(const C3D_Tex* tex) {
+    if (tex != lastTex) {
+        lastTex = tex;
+        hostMutableStats()->textureBinds++;
+    }
+}
+
+}
+
+bool C3D_Init(size_t) { return true; }
+void C3D_Fini(void) {}
+
+bool C3D_FrameBegin(u8 flags) {
+    if ((flags & C3D_FRAME_SYNCDRAW) && vsyncEnabled()) {
+        waitForVBlank();
+    }
+    hostMutableStats()->frames++;
+    lastTex = nullptr;
+    return true;
+}
+
+void C3D_FrameEnd(u8) {}
+
+bool C2D_Init(size_t) { return true; }
+void C2D_Fini(void) {}
+void C2D_Prepare(void) {}
+
+C3D_RenderTarget* C2D_CreateScreenTarget(gfxScreen_t screen, gfx3dSide_t) {
+    return &targets[screen == GFX_TOP ? 0 : 1];
+}
+
+void C2D_TargetClear(C3D_RenderTarget*, u32) {}
+
+void C2D_SceneBegin(C3D_RenderTarget*) {
+    lastTex = nullptr;
+}
+
+// .t3x layout: u16 subtexture count, u8 packed log2 size, u8 GPU format,
+// u8 mip levels, then per subtexture u16 width/height and four u16 texcoords
+// in 1/1024 units, followed by the compressed texture data.
+C2D_SpriteSheet C2D_SpriteSheetLoadFromMem(const void* data, size_t size) {
+    const u8* bytes = (const u8*)data;
+    if (size < 5) return nullptr;
+    u16 count = readU16(bytes);
+    size_t offset = 5 + count * 12;
+    if (offset + 4 > size) return nullptr;
+
+    C2D_SpriteSheet sheet = new C2D_SpriteSheet_s();
+    sheet->tex.width = 1 << ((bytes[2] & 7) + 3);
+    sheet->tex.height = 1 << (((bytes[2] >> 3) & 7) + 3);
+    sheet->tex.fmt = (GPU_TEXCOLOR)bytes[3];
+    sheet->subtextures.resize(count);
+    for (int i = 0; i < count; i++) {
+        const u8* sub = bytes + 5 + i * 12;
+        sheet->subtextures[i].width = readU16(sub);
+        sheet->subtextures[i].height = readU16(sub + 2);
+        sheet->subtextures[i].left = readU16(sub + 4) / 1024.0f;
+        sheet->subtextures[i].top = readU16(sub + 6) / 1024.0f;
+        sheet->subtextures[i].right = readU16(sub + 8) / 1024.0f;
+        sheet->subtextures[i].bottom = readU16(sub + 10) / 1024.0f;
+    }
+
+    u8 type = bytes[offset];
+    size_t rawSize = bytes[offset + 1] | (bytes[offset + 2] << 8) | (bytes[offset + 3] << 16);
+    offset += 4;
+    if (rawSize == 0 && offset + 4 <= size) {
+        rawSize = bytes[offset] | (bytes[offset + 1] << 8) | (bytes[offset + 2] << 16) | ((size_t)bytes[offset + 3] << 24);
+        offset += 4;
+    }
+    sheet->tex.size = rawSize;
+    sheet->tex.data = linearAlloc(rawSize);
+    bool ok = sheet->tex.data != nullptr;
+    if (ok && type == 0x11) {
+        ok = lz11Decompress(bytes + offset, size - offset, (u8*)sheet->tex.data, rawSize);
+    } else if (ok && type == 0x00) {
+        ok = offset + rawSize <= size;
+        if (ok) memcpy(sheet->tex.data, bytes + offset, rawSize);
+    } else {
+        ok = false;
+    }
+    if (!ok) {
+        C2D_SpriteSheetFree(sheet);
+        return nullptr;
+    }
+    return sheet;
+}
+
+C2D_SpriteSheet C2D_SpriteSheetLoad(const char* filename) {
+    FILE* file = fopen(filename, "rb");
+    if (!file) return nullptr;
+    std::vector<u8> data;
+    u8 buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), file)) > 0) {
+        data.insert(data.end(), buf, buf + n);
+    }
+    fclose(file);
+    return C2D_SpriteSheetLoadFromMem(data.data(), data.size());
+}
+
+void C2D_SpriteSheetFree(C2D_SpriteSheet sheet) {
+    if (!sheet) return;
+    linearFree(sheet->tex.data);
+    delete sheet;
+}
+
+size_t C2D_SpriteSheetCount(C2D_SpriteSheet sheet) {
+    return sheet ? sheet->subtextures.size() : 0;
+}
+
+C2D_Image C2D_SpriteSheetGetImage(C2D_SpriteSheet sheet, size_t index) {
+    return C2D_Image{&sheet->tex, &sheet->subtextures[index]};
+}
+
+bool C2D_DrawImage(C2D_Image img, const C2D_DrawParams*, const C2D_ImageTint*) {
+    bindTexture(img.tex);
+    hostMutableStats()->drawCalls++;
+    return true;
+}
+
+bool C2D_DrawRectSolid(float, float, float, float, float, u32) {
+    hostMutableStats()->rectDraws++;
+    return true;
+}
+
+C2D_TextBuf C2D_TextBufNew(size_t maxGlyphs) {
+    return new C2D_TextBuf_s{maxGlyphs, 0};
+}
+
+void C2D_TextBufDelete(C2D_TextBuf buf) {
+    delete buf;
+}
+
+void C2D_TextBufClear(C2D_TextBuf buf) {
+    buf->used = 0;
+}
+
+const char* C2D_TextParse(C2D_Text* text, C2D_TextBuf buf, const char* str) {
+    size_t len = std::string(str).size();
+    if (buf->used + len > buf->maxGlyphs) {
+        len = buf->maxGlyphs - buf->used;
+    }
+    text->buf = buf;
+    text->begin = buf->used;
+    text->end = buf->used + len;
+    text->width = len * 8.0f;
+    text->lines = 1;
+    text->words = 1;
+    text->font = nullptr;
+    buf->used += len;
+    return str + len;
+}
+
+void C2D_TextOptimize(const C2D_Text*) {}
+
+void C2D_TextGetDimensions(const C2D_Text* text, float scaleX, float scaleY, float* outWidth, float* outHeight) {
+    if (outWidth) *outWidth = text->width * scaleX;
+    if (outHeight) *outHeight = 30.0f * scaleY;
+}
+
+void C2D_DrawText(const C2D_Text* text, u32, float, float, float, float, float, ...) {
+    hostMutableStats()->textDraws++;
+    hostMutableStats()->drawCalls += text->end - text->begin;
+}
@@ -0,0 +1,319 @@
+// Host implementation of the libctru subset declared in host/include/3ds.h.
+#include <3ds.h>
+#include "stub_internal.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+
+namespace {
+
+HostStats stats = {};
+
+u64 frameLimit() {
+    static u64 limit = [] {
+        const char* env = std::getenv("ROCKET_HOST_FRAMES");
+        return env ? std::strtoull(env, nullptr, 10) : 300ULL;
+    }();
+    return limit;
+}
+u64 frameLimitOverride = 0;
+u64 loopCount = 0;
+
+u32 pendingHeld = 0, held = 0, down = 0, up = 0;
+circlePosition circle = {0, 0};
+
+const auto clockStart = std::chrono::steady_clock::now();
+
+u64 nanosSinceStart() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - clockStart).count() *
+           hostClockSpeed();
+}
+
+// The DSP is modelled as 24 channels that consume their queued wave buffers
+// in real time at the configured sample rate. State is advanced lazily
+// whenever a channel is touched.
+constexpr int NDSP_CHANNELS = 24;
+struct Channel {
+    float rate = 32728.0f;
+    u16 format = NDSP_FORMAT_MONO_PCM16;
+    ndspWaveBuf* head = nullptr;
+    ndspWaveBuf* tail = nullptr;
+    u64 lastNanos = 0;
+    double carry = 0.0;
+};
+Channel channels[NDSP_CHANNELS];
+std::mutex ndspMutex;
+bool ndspReady = false;
+
+void advance(Channel& ch) {
+    u64 now = nanosSinceStart();
+    double samples = (now - ch.lastNanos) * 1e-9 * ch.rate + ch.carry;
+    ch.lastNanos = now;
+    ch.carry = 0.0;
+    while (ch.head && samples > 0.0) {
+        ndspWaveBuf* buf = ch.head;
+        buf->status = NDSP_WBUF_PLAYING;
+        u32 remaining = buf->nsamples - buf->offset;
+        if (samples < remaining) {
+            buf->offset += (u32)samples;
+            ch.carry = samples - (u32)samples;
+            return;
+        }
+        samples -= remaining;
+        buf->offset = 0;
+        if (buf->looping) {
+            continue;
+        }
+        buf->status = NDSP_WBUF_DONE;
+        ch.head = buf->next;
+        if (!ch.head) {
+            ch.tail = nullptr;
+        }
+    }
+}
+
+bool validChannel(int id) {
+    return ndspReady && id >= 0 && id < NDSP_CHANNELS;
+}
+
+struct LinearHeader {
+    size_t size;
+    size_t pad;
+};
+
+}
+
+// ---------------------------------------------------------------- host API
+double hostClockSpeed(void) {
+    static double speed = [] {
+        const char* env = std::getenv("ROCKET_HOST_SPEED");
+        double value = env ? std::atof(env) : 1.0;
+        return value > 0 ? value : 1.0;
+    }();
+    return speed;
+}
+
+void hostSetFrameLimit(u64 frames) {
+    frameLimitOverride = frames;
+    loopCount = 0;
+}
+
+void hostRestartFrameCount(void) {
+    loopCount = 0;
+}
+
+void hostSetInput(u32 held_, s16 dx, s16 dy) {
+    pendingHeld = held_;
+    circle.dx = dx;
+    circle.dy = dy;
+}
+
+void hostScriptedInput(u64 frame, u32* held, s16* dx, s16* dy) {
+    // Eight compass directions, 1.5 s each, at full circle pad deflection.
+    static const s16 compass[8][2] = {{150, 0}, {106, 106}, {0, 150}, {-106, 106},
+                                      {-150, 0}, {-106, -106}, {0, -150}, {106, -106}};
+    u64 loop = frame % 720;
+    *held = 0;
+    *dx = 0;
+    *dy = 0;
+    // The last 1.5 s of each loop the stick is let go.
+    if (loop >= 630) return;
+    *dx = compass[loop / 90][0];
+    *dy = compass[loop / 90][1];
+    // The booster fires for the first half of each direction, burning fuel
+    // with R on every other loop.
+    if (loop % 90 < 45) {
+        *held = KEY_A;
+        if ((frame / 720) % 2) *held |= KEY_R;
+    }
+}
+
+const HostStats* hostGetStats(void) {
+    return &stats;
+}
+
+void hostResetStats(void) {
+    u64 live = stats.linearBytesLive;
+    stats = HostStats{};
+    stats.linearBytesLive = live;
+}
+
+HostStats* hostMutableStats(void) {
+    return &stats;
+}
+
+// ---------------------------------------------------------------- gfx / apt
+void gfxInitDefault(void) {}
+void gfxExit(void) {}
+PrintConsole* consoleInit(gfxScreen_t, PrintConsole* console) { return console; }
+void consoleClear(void) {}
+
+bool aptMainLoop(void) {
+    u64 limit = frameLimitOverride ? frameLimitOverride : frameLimit();
+    return loopCount++ < limit;
+}
+
+// Reports a New 3DS so the extra-core code paths get exercised.
+Result APT_CheckNew3DS(bool* out) {
+    *out = true;
+    return 0;
+}
+
+Result romfsInit(void) { return 0; }
+Result romfsExit(void) { return 0; }
+
+// ---------------------------------------------------------------------- hid
+void hidScanInput(void) {
+    down = pendingHeld & ~held;
+    up = held & ~pendingHeld;
+    held = pendingHeld;
+}
+u32 hidKeysDown(void) { return down; }
+u32 hidKeysHeld(void) { return held; }
+u32 hidKeysUp(void) { return up; }
+void hidCircleRead(circlePosition* pos) { *pos = circle; }
+
+// ----------------------------------------------------------------- svc/mem
+uint64_t osGetTime(void) {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+u64 svcGetSystemTick(void) {
+    return (u64)(nanosSinceStart() * (SYSCLOCK_ARM11 / 1e9));
+}
+
+void svcSleepThread(s64 ns) {
+    std::this_thread::sleep_for(std::chrono::nanoseconds((s64)(ns / hostClockSpeed())));
+}
+
+Result svcGetThreadPriority(s32* out, Handle) {
+    *out = 0x30;
+    return 0;
+}
+
+// ------------------------------------------------------------------ threads
+struct Thread_tag {
+    std::thread thread;
+};
+
+Thread threadCreate(ThreadFunc entrypoint, void* arg, size_t, int, int, bool detached) {
+    Thread thread = new Thread_tag{std::thread(entrypoint, arg)};
+    if (detached) thread->thread.detach();
+    return thread;
+}
+
+Result threadJoin(Thread thread, u64) {
+    if (thread && thread->thread.joinable()) thread->thread.join();
+    return 0;
+}
+
+void threadFree(Thread thread) {
+    delete thread;
+}
+
+void* linearAlloc(size_t size) {
+    LinearHeader* header = (LinearHeader*)std::malloc(sizeof(LinearHeader) + size);
+    if (!header) return nullptr;
+    header->size = size;
+    stats.linearBytesLive += size;
+    stats.linearAllocs++;
+    return header + 1;
+}
+
+void linearFree(void* mem) {
+    if (!mem) return;
+    LinearHeader* header = (LinearHeader*)mem - 1;
+    stats.linearBytesLive -= header->size;
+    std::free(header);
+}
+
+u32 linearSpaceFree(void) {
+    const u64 linearHeapSize = 32ULL * 1024 * 1024;
+    return stats.linearBytesLive > linearHeapSize ? 0 : (u32)(linearHeapSize - stats.linearBytesLive);
+}
+
+// --------------------------------------------------------------------- ndsp
+Result ndspInit(void) {
+    std::lock_guard<std::mutex> lock(ndspMutex);
+    for (auto& ch : channels) {
+        ch = Channel{};
+        ch.lastNanos = nanosSinceStart();
+    }
+    ndspReady = true;
+    return 0;
+}
+
+void ndspExit(void) {
+    std::lock_guard<std::mutex> lock(ndspMutex);
+    ndspReady = false;
+}
+
+void ndspSetOutputMode(ndspOutputMode) {}
+
+void ndspChnReset(int id) {
+    std::lock_guard<std::mutex> lock(ndspMutex);
+    if (!validChannel(id)) return;
+    channels[id] = Channel{};
+    channels[id].lastNanos = nanosSinceStart();
+}
+
+void ndspChnWaveBufClear(int id) {
+    std::lock_guard<std::mutex> lock(ndspMutex);
+    if (!validChannel(id)) return;
+    for (ndspWaveBuf* buf = channels[id].head; buf; buf = buf->next) {
+        buf->status = NDSP_WBUF_DONE;
+    }
+    channels[id].head = channels[id].tail = nullptr;
+    channels[id].carry = 0.0;
+}
+
+void ndspChnWaveBufAdd(int id, ndspWaveBuf* buf) {
+    std::lock_guard<std::mutex> lock(ndspMutex);
+    if (!validChannel(id) || !buf) return;
+    Channel& ch = channels[id];
+    advance(ch);
+    if (!ch.head) {
+        ch.lastNanos = nanosSinceStart();
+    }
+    buf->status = NDSP_WBUF_QUEUED;
+    buf->offset = 0;
+    buf->next = nullptr;
+    if (ch.tail) {
+        ch.tail->next = buf;
+    } else {
+        ch.head = buf;
+    }
+    ch.tail = buf;
+    stats.waveBufsQueued++;
+}
+
+void ndspChnSetInterp(int, ndspInterpType) {}
+
+void ndspChnSetRate(int id, float rate) {
+    std::lock_guard<std::mutex> lock(ndspMutex);
+    if (!validChannel(id)) return;
+    advance(channels[id]);
+    channels[id].rate = rate;
+}
+
+void ndspChnSetFormat(int id, u16 format) {
+    std::lock_guard<std::mutex> lock(ndspMutex);
+    if (!validChannel(id)) return;
+    channels[id].format = format;
+}
+
+void ndspChnSetMix(int, float[12]) {}
+
+bool ndspChnIsPlaying(int id) {
+    std::lock_guard<std::mutex> lock(ndspMutex);
+    if (!validChannel(id)) return false;
+    advance(channels[id]);
+    return channels[id].head != nullptr;
+}
+
+Result DSP_FlushDataCache(const void*, u32) {
+    return 0;
+}
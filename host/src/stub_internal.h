@@ -0,0 +1,11 @@
+// Shared between the host stub translation units only.
+#pragma once
+
+#include <host_platform.h>
+
+HostStats* hostMutableStats(void);
+
+// How many times faster than real time the host clock runs
+// ($ROCKET_HOST_SPEED, default 1). The system tick, the DSP, sleeps and the
+// stand-in vblank all follow it.
+double hostClockSpeed(void);
@@ -0,0 +1,86 @@
+// Replaces the global operator new/delete so the frame loop can check that
+// it runs without touching the heap once the game is warmed up, and so every
+// heap block is charged to the subsystem that allocated it (see memory.h).
+#include "alloc_counter.h"
+#include "memory.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<u64> allocations{0};
+static std::atomic<s64> liveBytes[MEM_TAG_COUNT][MEM_KIND_COUNT];
+static std::atomic<s64> peakBytes[MEM_TAG_COUNT][MEM_KIND_COUNT];
+static thread_local MemTag currentTag = MEM_UNTAGGED;
+static thread_local u64 threadAllocations = 0;
+
+// Each heap block starts with its size and tag so delete can credit the
+// right subsystem. 16 bytes keeps the block as aligned as malloc made it.
+struct BlockHeader {
+    u32 size;
+    u8 tag;
+    u8 pad[11];
+};
+static_assert(sizeof(BlockHeader) == 16, "heap block header must stay 16 bytes");
+
+u64 heapAllocationCount() {
+    return allocations.load(std::memory_order_relaxed);
+}
+
+u64 threadHeapAllocationCount() {
+    return threadAllocations;
+}
+
+void memoryTrack(MemTag tag, MemKind kind, s64 bytes) {
+    s64 live = liveBytes[tag][kind].fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    s64 peak = peakBytes[tag][kind].load(std::memory_order_relaxed);
+    while (live > peak && !peakBytes[tag][kind].compare_exchange_weak(peak, live, std::memory_order_relaxed)) {
+    }
+}
+
+MemoryUsage memoryUsage(MemTag tag, MemKind kind) {
+    return MemoryUsage{liveBytes[tag][kind].load(std::memory_order_relaxed), peakBytes[tag][kind].load(std::memory_order_relaxed)};
+}
+
+MemTag currentMemoryTag() {
+    return currentTag;
+}
+
+void setCurrentMemoryTag(MemTag tag) {
+    currentTag = tag;
+}
+
+void* operator new(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    threadAllocations++;
+    if (size == 0) size = 1;
+    BlockHeader* header = (BlockHeader*)std::malloc(sizeof(BlockHeader) + size);
+    if (!header) std::abort();
+    header->size = size;
+    header->tag = currentTag;
+    memoryTrack(currentTag, MEM_HEAP, size);
+    return header + 1;
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept {
+    if (!ptr) return;
+    BlockHeader* header = (BlockHeader*)ptr - 1;
+    memoryTrack((MemTag)header->tag, MEM_HEAP, -(s64)header->size);
+    std::free(header);
+}
+
+void operator delete[](void* ptr) noexcept {
+    operator delete(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    operator delete(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+    operator delete(ptr);
+}
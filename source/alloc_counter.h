@@ -0,0 +1,30 @@
+#pragma once
+
+#include "main.h"
+
+// Number of global operator new calls since startup (see alloc_counter.cpp).
+u64 heapAllocationCount();
+// The same, but only those made by the calling thread.
+u64 threadHeapAllocationCount();
+
+// Counts allocations across a region of the frame loop, e.g.
+//   AllocationWatch watch; ...; watch.count()
+class AllocationWatch {
+    u64 start;
+public:
+    AllocationWatch() : start(heapAllocationCount()) {}
+    u64 count() const {
+        return heapAllocationCount() - start;
+    }
+};
+
+// Like AllocationWatch, but only counts the calling thread's allocations, so
+// other threads' work can neither trip nor hide a check.
+class ThreadAllocationWatch {
+    u64 start;
+public:
+    ThreadAllocationWatch() : start(threadHeapAllocationCount()) {}
+    u64 count() const {
+        return threadHeapAllocationCount() - start;
+    }
+};
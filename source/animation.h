@@ -0,0 +1,97 @@
+#pragma once
+
+#include "main.h"
+#include "atlas_index.h"
+
+#define ANIM_MAX_STEPS 32
+
+// One frame of a clip: the atlas image, how many simulation steps it shows
+// for, and the point (as a fraction of the image) it is drawn centred on.
+struct AnimFrame {
+    u16 image;
+    u8 steps;
+    float pivotX = 0.5f, pivotY = 0.5f;
+};
+
+enum AnimClip : u8 {
+    ANIM_EXPLOSION_A,
+    ANIM_EXPLOSION_B,
+    ANIM_ROCKET_IDLE,
+    ANIM_ROCKET_BOOST,
+    ANIM_CLIP_COUNT,
+};
+
+// Explosions run for EXPLOSION_FRAMES + 1 steps and shake a little by moving
+// the pivot. The boosting rocket drops its flame for a step now and then.
+static const AnimFrame ANIM_EXPLOSION_A_FRAMES[] = {
+    {ATLAS_ASTEROIDS_4, 6, 0.45f, 0.5f},
+    {ATLAS_ASTEROIDS_5, 7, 0.55f, 0.45f},
+    {ATLAS_ASTEROIDS_6, 8, 0.5f, 0.55f},
+};
+static const AnimFrame ANIM_EXPLOSION_B_FRAMES[] = {
+    {ATLAS_ASTEROIDS_4, 5, 0.55f, 0.5f},
+    {ATLAS_ASTEROIDS_6, 8, 0.45f, 0.55f},
+    {ATLAS_ASTEROIDS_5, 8, 0.5f, 0.45f},
+};
+static const AnimFrame ANIM_ROCKET_IDLE_FRAMES[] = {
+    {ATLAS_ROCKET_OFF, 1},
+};
+static const AnimFrame ANIM_ROCKET_BOOST_FRAMES[] = {
+    {ATLAS_ROCKET_ON, 5},
+    {ATLAS_ROCKET_OFF, 1},
+    {ATLAS_ROCKET_ON, 3},
+    {ATLAS_ROCKET_OFF, 1},
+};
+
+// The clips above expanded once into a step -> frame lookup, so an animation
+// is just a step counter: finding its frame is one table read, and moving it
+// on is an increment with a wrap (looping clips) or a clamp (one-shots).
+// Nothing divides, which matters on the ARM11.
+class AnimationTable {
+    struct Clip {
+        const AnimFrame* frames;
+        u8 length;
+        bool loop;
+        u8 frameAtStep[ANIM_MAX_STEPS];
+    };
+    Clip clips[ANIM_CLIP_COUNT];
+
+    void build(AnimClip id, const AnimFrame* frames, int count, bool loop) {
+        Clip & clip = clips[id];
+        clip.frames = frames;
+        clip.loop = loop;
+        clip.length = 0;
+        for (int f = 0; f < count; f++) {
+            for (int s = 0; s < frames[f].steps && clip.length < ANIM_MAX_STEPS; s++) {
+                clip.frameAtStep[clip.length++] = f;
+            }
+        }
+    }
+public:
+    AnimationTable() {
+        build(ANIM_EXPLOSION_A, ANIM_EXPLOSION_A_FRAMES, 3, false);
+        build(ANIM_EXPLOSION_B, ANIM_EXPLOSION_B_FRAMES, 3, false);
+        build(ANIM_ROCKET_IDLE, ANIM_ROCKET_IDLE_FRAMES, 1, true);
+        build(ANIM_ROCKET_BOOST, ANIM_ROCKET_BOOST_FRAMES, 4, true);
+    }
+
+    // `step` must be one advance() has produced (or 0).
+    const AnimFrame & frameAt(AnimClip id, u32 step) const {
+        const Clip & clip = clips[id];
+        return clip.frames[clip.frameAtStep[step]];
+    }
+    u32 advance(AnimClip id, u32 step) const {
+        const Clip & clip = clips[id];
+        if (++step < clip.length) return step;
+        return clip.loop ? 0 : clip.length - 1;
+    }
+    int length(AnimClip id) const {
+        return clips[id].length;
+    }
+};
+
+// Built on first use; main() touches it at startup so that is at load time.
+inline const AnimationTable & animations() {
+    static const AnimationTable table;
+    return table;
+}
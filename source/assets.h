@@ -0,0 +1,203 @@
+#pragma once
+
+#include "main.h"
+#include "audio.h"
+#include "pak_format.h"
+#include "memory.h"
+
+#define ASSET_ARCHIVE_PATH "romfs:/game.pak"
+
+// The packed asset archive (see pak_format.h). open() pulls the whole file
+// into memory with one sequential read and checks the index; nothing is
+// decoded until it is asked for. A texture becomes a sprite sheet on its
+// first sheet() call. A sound is handed to the SoundBank as encoded bytes
+// and decoded the first time it plays. Each asset's checksum is verified on
+// first access.
+//
+// Timings are kept so startup and first-use costs can be reported.
+class AssetArchive {
+    struct Slot {
+        const PakEntry* entry;
+        bool verified = false;
+        bool corrupt = false;
+        C2D_SpriteSheet sheet = nullptr;
+        int soundId = -1;
+        u64 materializeTicks = 0;
+    };
+
+    std::vector<u8> blob;
+    std::vector<Slot> slots;
+    u64 openTicks = 0;
+    const char* path = "";
+
+    // Returns the asset's bytes, or nullptr if its checksum does not match.
+    const u8* bytes(Slot & slot) {
+        const u8* data = blob.data() + slot.entry->offset;
+        if (!slot.verified && !slot.corrupt) {
+            if (pakCrc32(data, slot.entry->size) == slot.entry->crc32) {
+                slot.verified = true;
+            } else {
+                printf("%s: checksum mismatch for %s\n", path, slot.entry->name);
+                slot.corrupt = true;
+            }
+        }
+        return slot.corrupt ? nullptr : data;
+    }
+
+    Slot* lookup(const char* name, PakFormat format) {
+        int lo = 0, hi = slots.size() - 1;
+        while (lo <= hi) {
+            int mid = (lo + hi) / 2;
+            int cmp = strncmp(name, slots[mid].entry->name, PAK_NAME_LENGTH);
+            if (cmp == 0) {
+                if (slots[mid].entry->format != format) {
+                    printf("%s: %s has the wrong format\n", path, name);
+                    return nullptr;
+                }
+                return &slots[mid];
+            }
+            if (cmp < 0) {
+                hi = mid - 1;
+            } else {
+                lo = mid + 1;
+            }
+        }
+        printf("%s: no asset named %s\n", path, name);
+        return nullptr;
+    }
+
+    static u32 textureBytes(C2D_SpriteSheet sheet) {
+        return C2D_SpriteSheetCount(sheet) ? C2D_SpriteSheetGetImage(sheet, 0).tex->size : 0;
+    }
+
+    static float ticksToMs(u64 ticks) {
+        return ticks / (SYSCLOCK_ARM11 / 1000.0f);
+    }
+
+public:
+    AssetArchive() {}
+    ~AssetArchive() {
+        for (auto & slot : slots) {
+            if (slot.sheet) {
+                memoryTrack(MEM_ASSETS, MEM_TEXTURE, -(s64)textureBytes(slot.sheet));
+                C2D_SpriteSheetFree(slot.sheet);
+            }
+        }
+    }
+    AssetArchive(const AssetArchive&) = delete;
+    AssetArchive& operator=(const AssetArchive&) = delete;
+
+    bool open(const char* path_) {
+        MemoryScope scope(MEM_ASSETS);
+        u64 start = svcGetSystemTick();
+        path = path_;
+        FILE* file = fopen(path, "rb");
+        if (!file) {
+            printf("Failed to open %s\n", path);
+            return false;
+        }
+        fseek(file, 0, SEEK_END);
+        long size = ftell(file);
+        fseek(file, 0, SEEK_SET);
+        blob.resize(size > 0 ? size : 0);
+        bool ok = size > 0 && fread(blob.data(), 1, size, file) == (size_t)size;
+        fclose(file);
+
+        const PakHeader* header = (const PakHeader*)blob.data();
+        if (!ok || blob.size() < sizeof(PakHeader) || header->magic != PAK_MAGIC || header->version != PAK_VERSION ||
+            blob.size() < sizeof(PakHeader) + (size_t)header->count * sizeof(PakEntry)) {
+            printf("%s is not a version %d asset archive\n", path, PAK_VERSION);
+            blob.clear();
+            return false;
+        }
+        const PakEntry* entries = (const PakEntry*)(blob.data() + sizeof(PakHeader));
+        slots.clear();
+        slots.reserve(header->count);
+        for (u32 i = 0; i < header->count; i++) {
+            if ((size_t)entries[i].offset + entries[i].size > blob.size()) {
+                printf("%s: %.*s runs past the end of the file\n", path, PAK_NAME_LENGTH, entries[i].name);
+                slots.clear();
+                blob.clear();
+                return false;
+            }
+            Slot slot;
+            slot.entry = &entries[i];
+            slots.push_back(slot);
+        }
+        openTicks = svcGetSystemTick() - start;
+        return true;
+    }
+
+    // Checks every asset's checksum now instead of on first use, so the
+    // loader thread can take that cost. Returns false if any is corrupt.
+    bool verifyAll() {
+        bool ok = true;
+        for (Slot & slot : slots) {
+            ok = bytes(slot) && ok;
+        }
+        return ok && !slots.empty();
+    }
+
+    // The sprite sheet for a .t3x asset, loaded from memory on first call.
+    C2D_SpriteSheet sheet(const char* name) {
+        Slot* slot = lookup(name, PAK_FORMAT_T3X);
+        if (!slot) return nullptr;
+        if (!slot->sheet) {
+            MemoryScope scope(MEM_ASSETS);
+            u64 start = svcGetSystemTick();
+            const u8* data = bytes(*slot);
+            if (data) {
+                slot->sheet = C2D_SpriteSheetLoadFromMem(data, slot->entry->size);
+            }
+            if (slot->sheet) {
+                memoryTrack(MEM_ASSETS, MEM_TEXTURE, textureBytes(slot->sheet));
+            }
+            slot->materializeTicks = svcGetSystemTick() - start;
+        }
+        return slot->sheet;
+    }
+
+    // Registers a .wav asset with the bank. It is decoded when the bank
+    // materializes it, or else on first play, so the archive must stay open
+    // for as long as the sound can be played.
+    int sound(const char* name, SoundBank & bank) {
+        Slot* slot = lookup(name, PAK_FORMAT_WAV);
+        if (!slot) return -1;
+        if (slot->soundId < 0) {
+            u64 start = svcGetSystemTick();
+            const u8* data = bytes(*slot);
+            if (data) {
+                slot->soundId = bank.registerMemory(name, data, slot->entry->size);
+            }
+            slot->materializeTicks = svcGetSystemTick() - start;
+        }
+        return slot->soundId;
+    }
+
+    size_t sizeBytes() const {
+        return blob.size();
+    }
+    float openMs() const {
+        return ticksToMs(openTicks);
+    }
+
+    // One line per asset: how big it is and what its first use cost. For
+    // sounds that includes the decode, if it has happened.
+    void report(FILE* out, const SoundBank & bank) const {
+        fprintf(out, "%s: %zu bytes, read and indexed in %.2f ms\n", path, blob.size(), openMs());
+        for (const Slot & slot : slots) {
+            const char* state = slot.corrupt ? "corrupt" : slot.sheet || slot.soundId >= 0 ? "loaded" : "unused";
+            fprintf(out, "  %-*.*s %8lu bytes  %-7s  first use %.2f ms", PAK_NAME_LENGTH, PAK_NAME_LENGTH, slot.entry->name,
+                    (unsigned long)slot.entry->size, state, ticksToMs(slot.materializeTicks));
+            const Sound* sound = bank.peek(slot.soundId);
+            if (sound) {
+                if (sound->wav.data) {
+                    fprintf(out, ", decoded in %.2f ms", ticksToMs(sound->decodeTicks));
+                } else {
+                    fprintf(out, ", never decoded");
+                }
+            }
+            fprintf(out, "\n");
+        }
+    }
+};
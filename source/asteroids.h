@@ -0,0 +1,428 @@
+#pragma once
+
+#include "main.h"
+#include "audio.h"
+#include "player.h"
+#include "simd.h"
+#include "grid.h"
+#include "ecs.h"
+#include "snapshot.h"
+#include "random.h"
+#include "particles.h"
+#include "animation.h"
+#include "memory.h"
+#include "state_hash.h"
+#include "collision_mask.h"
+#include "world.h"
+
+#include <cassert>
+
+#define EXPLOSION_FRAMES 20
+
+// Every live asteroid can turn into at most one explosion, and explosions
+// outlive their asteroid by EXPLOSION_FRAMES steps, so twice the asteroid
+// limit plus some slack covers any realistic wave.
+inline int explosionCapacityFor(int asteroidLimit) {
+    return asteroidLimit * 2 + 8;
+}
+
+// Explosions sit still and play a one-shot clip, then go after
+// EXPLOSION_FRAMES steps. The table is a fixed-capacity pool: a new
+// explosion is dropped (and counted) rather than growing it when it is full.
+typedef EntityTable<Transform, Animation, Lifetime> ExplosionTable;
+
+class AsteroidExplosions {
+    ExplosionTable table;
+    Rng & rng;
+    u32 dropped = 0;
+
+    // Rock fragments plus a few short-lived sparks.
+    void emitDebris(float x, float y) {
+        ParticleBurst burst;
+        burst.x = x;
+        burst.y = y;
+        burst.speedMin = 30;
+        burst.speedMax = 110;
+        burst.life = 0.8f;
+        burst.color = C2D_Color32(150, 120, 95, 255);
+        debris->emit(burst, 40);
+        burst.speedMax = 160;
+        burst.life = 0.35f;
+        burst.color = C2D_Color32(255, 220, 120, 255);
+        burst.size = 1.5f;
+        debris->emit(burst, 16);
+    }
+public:
+    // Where destroyed asteroids throw their debris; none if this is null.
+    Particles* debris = nullptr;
+    AsteroidExplosions(int capacity, Rng & rng_) : table(0), rng(rng_) {
+        MemoryScope scope(MEM_EXPLOSIONS);
+        table = ExplosionTable(capacity);
+    }
+    EntityHandle addExplosion(double x, double y) {
+        if (table.full()) {
+            dropped++;
+            return EntityHandle{};
+        }
+        EntityHandle handle = table.add();
+        int i = table.count() - 1;
+        table.get<Transform>().place(i, x, y);
+        table.get<Animation>().clip[i] = rng.below(2) ? ANIM_EXPLOSION_B : ANIM_EXPLOSION_A;
+        if (debris) {
+            emitDebris(x, y);
+        }
+        return handle;
+    }
+    // Dense index for a handle, or -1 if that explosion is over.
+    int indexOf(EntityHandle handle) const {
+        return table.indexOf(handle);
+    }
+    int count() const {
+        return table.count();
+    }
+    u32 droppedCount() const {
+        return dropped;
+    }
+    void hashState(StateHash & hash) const {
+        hash.add(table.get<Transform>().x);
+        hash.add(table.get<Transform>().y);
+        hash.add(table.get<Animation>().clip);
+        hash.add(table.get<Lifetime>().frames);
+    }
+    void snapshotExplosions(RenderSnapshot & out) const {
+        animatedSpriteSystem(table.get<Transform>(), table.get<Animation>(), LAYER_EXPLOSIONS, count(), out);
+    }
+    void updateExplosions() {
+        ageSystem(table.get<Lifetime>(), count());
+        animateSystem(table.get<Animation>(), count());
+        const std::vector<int> & frames = table.get<Lifetime>().frames;
+        for (int i = count() - 1; i >= 0; i--) {
+            if (frames[i] > EXPLOSION_FRAMES) {
+                table.remove(i);
+            }
+        }
+    }
+
+};
+
+// ATLAS_ASTEROIDS_0 is an empty cell of the sheet, so rocks start at 1.
+#define ASTEROID_FIRST_IMAGE ATLAS_ASTEROIDS_1
+#define ASTEROID_IMAGE_COUNT 3
+// Fastest spin either way, in hundredths of a radian per second.
+#define ASTEROID_MAX_SPIN 150
+// At least the widest pair of rock bounds, so touching rocks are always in
+// the same or neighbouring cells.
+#define COLLISION_CELL_SIZE 32.0f
+#define COLLISION_MAX_PER_CELL 16
+
+enum AsteroidHit : u8 {
+    HIT_NONE = 0,
+    HIT_PLAYER = 1,
+};
+
+// Asteroids move, spin, are drawn with a fixed image and collide. Each
+// pass below touches only the components it needs, as packed arrays, so
+// the integration and the grid build walk contiguous memory.
+typedef EntityTable<Transform, Velocity, SpriteRef, Collider> AsteroidTable;
+
+// Side of the square the near chunks cover, which the collision grid spans.
+#define NEAR_AREA_SIZE ((2 * WORLD_NEAR_RADIUS + 1) * WORLD_CHUNK_SIZE)
+
+// Most far rocks that drifted off screen from the near table; the rest of
+// the far table is kept for chunks' starting rocks.
+inline int farDriftLimitFor(int asteroidLimit) {
+    return WORLD_LIVE_CHUNKS * WORLD_ROCKS_PER_CHUNK + asteroidLimit;
+}
+// Room for the far rocks: the drift limit plus a full live window's worth of
+// starting rocks, so a chunk that comes into range always gets all of its
+// rocks and looks the same every time it comes back.
+inline int farCapacityFor(int asteroidLimit) {
+    return farDriftLimitFor(asteroidLimit) + WORLD_LIVE_CHUNKS * WORLD_ROCKS_PER_CHUNK;
+}
+
+// Rocks are kept in two tables by where they are in the world (see
+// world.h). The near table is in the near chunks: it is drawn, collides
+// and moves every step, and the wave limit applies to it. The far table is
+// everything else in the live chunks: it only moves every
+// WORLD_FAR_INTERVAL steps and never collides. stream() moves rocks
+// between the two as they or the player cross chunks, and drops the ones
+// that end up outside the live chunks.
+class Asteroids {
+    SpatialGrid grid{NEAR_AREA_SIZE, NEAR_AREA_SIZE, COLLISION_CELL_SIZE};
+    std::vector<u8> hits;
+    AsteroidTable table;
+    AsteroidTable farTable;
+    Rng & rng;
+    u32 ticks = 0;
+    u32 dropped = 0;
+    u32 crowded = 0;
+
+    void addRock(AsteroidTable & into, float x, float y, float xVel, float yVel, float spin, int image) {
+        into.add();
+        int i = into.count() - 1;
+        into.get<Transform>().place(i, x, y);
+        into.get<Velocity>().x[i] = xVel;
+        into.get<Velocity>().y[i] = yVel;
+        into.get<Velocity>().spin[i] = spin;
+        into.get<SpriteRef>().image[i] = image;
+        into.get<Collider>().shape[i] = image;
+        into.get<Collider>().radius[i] = collisionShapes().shape(image).radius();
+    }
+    bool farTick() const {
+        return ticks % WORLD_FAR_INTERVAL == 0;
+    }
+    // Drops far rocks that are no longer in a live chunk.
+    void evictFar(const WorldStreamer & world) {
+        const std::vector<float> & x = farTable.get<Transform>().x;
+        const std::vector<float> & y = farTable.get<Transform>().y;
+        for (int i = farCount() - 1; i >= 0; i--) {
+            if (!world.isLive(x[i], y[i])) {
+                farTable.remove(i);
+            }
+        }
+    }
+public:
+    int asteroidLimit = 0;
+    int explosionSound = -1;
+    Asteroids(int asteroidLimit_, Rng & rng_) : table(0), farTable(0), rng(rng_), asteroidLimit(asteroidLimit_) {
+        MemoryScope scope(MEM_ASTEROIDS);
+        table = AsteroidTable(asteroidLimit);
+        farTable = AsteroidTable(farCapacityFor(asteroidLimit));
+        grid = SpatialGrid(NEAR_AREA_SIZE, NEAR_AREA_SIZE, COLLISION_CELL_SIZE);
+        hits.reserve(asteroidLimit);
+        grid.reserve(asteroidLimit);
+    }
+    // Rocks in the near chunks.
+    int count() const {
+        return table.count();
+    }
+    // Rocks in the rest of the live chunks.
+    int farCount() const {
+        return farTable.count();
+    }
+    // Rocks that drifted off screen while the far table was full.
+    u32 droppedCount() const {
+        return dropped;
+    }
+    // Rocks left out of the bounce test, summed over steps, because their
+    // cell already held COLLISION_MAX_PER_CELL. Rocks outside the near area
+    // pile into its edge cells, so they count here too.
+    u32 crowdedCount() const {
+        return crowded;
+    }
+    // Enters from a random edge of the view whose top-left corner is at
+    // (viewX, viewY); speedScale multiplies the random velocity.
+    EntityHandle spawnAsteroid(float speedScale = 1.0f, float viewX = 0, float viewY = 0) {
+        if (count() >= asteroidLimit) {
+            return EntityHandle{};
+        }
+        float ax = 0, ay = 0, axVel = 0, ayVel = 0;
+        int edge = rng.below(4);
+        if (edge == 0) {
+            ax = 1;
+            ay = rng.below(TOP_HEIGHT);
+            axVel = rng.below(100);
+            ayVel = rng.between(-100, 100);
+        } else if (edge == 1) {
+            ax = rng.below(TOP_WIDTH);
+            ay = 1;
+            axVel = rng.between(-100, 100);
+            ayVel = rng.below(100);
+        }else if (edge == 2) {
+            ax = TOP_WIDTH-1;
+            ay = rng.below(TOP_HEIGHT);
+            axVel = -rng.below(100);
+            ayVel = rng.between(-100, 100);
+        } else if (edge == 3) {
+            ax = rng.below(TOP_WIDTH);
+            ay = TOP_HEIGHT-1;
+            axVel = rng.between(-100, 100);
+            ayVel = -rng.below(100);
+        }
+        int image = ASTEROID_FIRST_IMAGE + rng.below(ASTEROID_IMAGE_COUNT);
+        float spin = rng.between(-ASTEROID_MAX_SPIN, ASTEROID_MAX_SPIN) / 100.0f;
+        addRock(table, viewX + ax, viewY + ay, axVel * speedScale, ayVel * speedScale, spin, image);
+        return table.handleAt(count() - 1);
+    }
+    // Starting contents of a chunk that just came into range: a few slow
+    // rocks, from the chunk's own generator so the game's stays untouched.
+    // Chunks created near the player start empty, so nothing appears on
+    // screen out of nowhere.
+    void populateChunk(const WorldStreamer & world, int cx, int cy) {
+        if (world.isNearChunk(cx, cy)) {
+            return;
+        }
+        Rng chunkRng = world.chunkRng(cx, cy);
+        int rocks = chunkRng.below(WORLD_ROCKS_PER_CHUNK + 1);
+        if (DEBUG) {
+            assert(farCount() + rocks <= farCapacityFor(asteroidLimit));
+        }
+        for (int r = 0; r < rocks && !farTable.full(); r++) {
+            float x = cx * WORLD_CHUNK_SIZE + chunkRng.below((int)WORLD_CHUNK_SIZE);
+            float y = cy * WORLD_CHUNK_SIZE + chunkRng.below((int)WORLD_CHUNK_SIZE);
+            float xVel = chunkRng.between(-40, 40), yVel = chunkRng.between(-40, 40);
+            float spin = chunkRng.between(-ASTEROID_MAX_SPIN, ASTEROID_MAX_SPIN) / 100.0f;
+            addRock(farTable, x, y, xVel, yVel, spin, ASTEROID_FIRST_IMAGE + chunkRng.below(ASTEROID_IMAGE_COUNT));
+        }
+    }
+    // Follows the player with the live chunks and sorts rocks into the
+    // near and far tables. Near rocks are checked every step, since they
+    // are few and collide. Far rocks only move on far ticks, so they are
+    // only checked then, or when the chunks themselves moved.
+    void stream(WorldStreamer & world, float playerX, float playerY) {
+        bool moved = world.follow(playerX, playerY, [&] { evictFar(world); },
+                                  [&](int cx, int cy) { populateChunk(world, cx, cy); });
+        grid.setOrigin(world.nearOriginX(), world.nearOriginY());
+        {
+            const std::vector<float> & x = table.get<Transform>().x;
+            const std::vector<float> & y = table.get<Transform>().y;
+            int driftLimit = farDriftLimitFor(asteroidLimit);
+            for (int i = count() - 1; i >= 0; i--) {
+                if (world.isNear(x[i], y[i])) continue;
+                if (world.isLive(x[i], y[i]) && farCount() < driftLimit) {
+                    table.transfer(i, farTable);
+                } else {
+                    if (world.isLive(x[i], y[i])) dropped++;
+                    table.remove(i);
+                }
+            }
+        }
+        if (moved || farTick()) {
+            evictFar(world);
+            const std::vector<float> & x = farTable.get<Transform>().x;
+            const std::vector<float> & y = farTable.get<Transform>().y;
+            for (int i = farCount() - 1; i >= 0 && count() < asteroidLimit; i--) {
+                if (world.isNear(x[i], y[i])) {
+                    farTable.transfer(i, table);
+                }
+            }
+        }
+    }
+    // Index into the components for a handle, or -1 if that asteroid is gone.
+    int indexOf(EntityHandle handle) const {
+        return table.indexOf(handle);
+    }
+    EntityHandle handleAt(int i) const {
+        return table.handleAt(i);
+    }
+    void hashState(StateHash & hash) const {
+        hash.add(ticks);
+        for (const AsteroidTable* rocks : {&table, &farTable}) {
+            const Transform & t = rocks->get<Transform>();
+            const Velocity & v = rocks->get<Velocity>();
+            hash.add(t.x);
+            hash.add(t.y);
+            hash.add(v.x);
+            hash.add(v.y);
+            hash.add(t.rotation);
+            hash.add(rocks->get<SpriteRef>().image);
+        }
+    }
+    void snapshotAsteroids(RenderSnapshot & out) const {
+        spriteSystem(table.get<Transform>(), table.get<SpriteRef>(), LAYER_ASTEROIDS, count(), out);
+    }
+    // Far rocks take one step of WORLD_FAR_INTERVAL times dt on every
+    // WORLD_FAR_INTERVAL-th call.
+    void updateAsteroids(double dt) {
+        ticks++;
+        moveSystem(table.get<Transform>(), table.get<Velocity>(), count(), dt);
+        if (farTick()) {
+            moveSystem(farTable.get<Transform>(), farTable.get<Velocity>(), farCount(), dt * WORLD_FAR_INTERVAL);
+        }
+    }
+    // Equal-mass elastic bounce between two overlapping asteroids, plus a
+    // positional push so they do not stay interpenetrated.
+    void bounce(int a, int b) {
+        std::vector<float> & x = table.get<Transform>().x;
+        std::vector<float> & y = table.get<Transform>().y;
+        std::vector<float> & xVel = table.get<Velocity>().x;
+        std::vector<float> & yVel = table.get<Velocity>().y;
+        float dx = x[b] - x[a], dy = y[b] - y[a];
+        float distSq = dx * dx + dy * dy;
+        if (distSq < 1e-6f) {
+            return;
+        }
+        float dist = std::sqrt(distSq);
+        float nx = dx / dist, ny = dy / dist;
+        float approach = (xVel[a] - xVel[b]) * nx + (yVel[a] - yVel[b]) * ny;
+        if (approach > 0) {
+            xVel[a] -= approach * nx;
+            yVel[a] -= approach * ny;
+            xVel[b] += approach * nx;
+            yVel[b] += approach * ny;
+        }
+        const std::vector<float> & radius = table.get<Collider>().radius;
+        float push = (radius[a] + radius[b] - dist) * 0.5f;
+        x[a] -= nx * push;
+        y[a] -= ny * push;
+        x[b] += nx * push;
+        y[b] += ny * push;
+    }
+    void asteroidsCollide(Player & player, AsteroidExplosions & explosions, VoiceManager & voices) {
+        int n = count();
+        const std::vector<float> & x = table.get<Transform>().x;
+        const std::vector<float> & y = table.get<Transform>().y;
+        const std::vector<float> & rotation = table.get<Transform>().rotation;
+        const Collider & collider = table.get<Collider>();
+        hits.assign(n, HIT_NONE);
+
+        grid.build(x.data(), y.data(), n);
+
+        // Bounding circles rule out almost every pair; only those that
+        // overlap go on to the pixel masks.
+        float px = player.getPosition().first, py = player.getPosition().second;
+        const CollisionShapes & shapes = collisionShapes();
+        const CollisionShape & playerShape = shapes.shape(ATLAS_ROCKET_OFF);
+        const CollisionMask & playerMask = playerShape.at(player.getHeading());
+        float reach = playerShape.radius() + shapes.largestRadius(ASTEROID_FIRST_IMAGE, ASTEROID_IMAGE_COUNT);
+        grid.query(px, py, reach, [&](int i) {
+            if (hits[i] != HIT_NONE) {
+                return;
+            }
+            float dx = px - x[i], dy = py - y[i], hitDist = playerShape.radius() + collider.radius[i];
+            if (dx * dx + dy * dy < hitDist * hitDist &&
+                masksOverlap(playerMask, px, py, shapes.shape(collider.shape[i]).at(radiansToAngle(rotation[i])), x[i], y[i])) {
+                if (!player.invulnerable) {
+                    player.health.damage(10.0);
+                }
+                hits[i] = HIT_PLAYER;
+            }
+        });
+
+        // Rocks bounce off each other as their bounding circles, which
+        // gives the bounce its normal. The grid finds pairs within the
+        // widest possible pair distance; each pair then uses its own radii.
+        float pairReach = 2 * shapes.largestRadius(ASTEROID_FIRST_IMAGE, ASTEROID_IMAGE_COUNT);
+        crowded += grid.forEachPair(x.data(), y.data(), pairReach, COLLISION_MAX_PER_CELL, [&](int a, int b) {
+            if (hits[a] != HIT_NONE || hits[b] != HIT_NONE) {
+                return;
+            }
+            float dx = x[b] - x[a], dy = y[b] - y[a], touch = collider.radius[a] + collider.radius[b];
+            if (dx * dx + dy * dy < touch * touch) {
+                bounce(a, b);
+            }
+        });
+
+        // Explosions are panned by where they are on screen. The camera
+        // follows the player but stops at the world's edges, so near an edge
+        // the player (and the hit) is off to one side.
+        float cameraX, cameraY;
+        cameraFor(px, py, cameraX, cameraY);
+        float screenCentreX = cameraX + TOP_WIDTH / 2;
+        for (int i = n - 1; i >= 0; i--) {
+            if (hits[i] == HIT_PLAYER) {
+                voices.play(explosionSound, SOUND_PRIORITY_NORMAL,
+                            std::clamp((x[i] - screenCentreX) / (TOP_WIDTH / 2), -1.0f, 1.0f));
+                explosions.addExplosion(x[i], y[i]);
+                table.remove(i);
+            }
+        }
+
+    }
+    void printAsteroids() {
+        const Transform & t = table.get<Transform>();
+        for (int i=0; i<count(); i++) {
+            std::cout << "\n Asteroid " << i << " | X: " << t.x[i] << ", Y: "  << t.y[i];
+        }
+    }
+};
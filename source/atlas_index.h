@@ -0,0 +1,21 @@
+// Generated by tools/atlas_pack; do not edit. Regenerate with the `atlas` CMake target.
+#pragma once
+
+// Name of the atlas in the asset archive.
+#define ATLAS_ASSET "atlas"
+#define ATLAS_WIDTH 512
+#define ATLAS_HEIGHT 256
+
+enum AtlasImage {
+    ATLAS_SPACE1 = 0,
+    ATLAS_ROCKET_ON = 1,
+    ATLAS_ROCKET_OFF = 2,
+    ATLAS_ASTEROIDS_0 = 3,
+    ATLAS_ASTEROIDS_1 = 4,
+    ATLAS_ASTEROIDS_2 = 5,
+    ATLAS_ASTEROIDS_3 = 6,
+    ATLAS_ASTEROIDS_4 = 7,
+    ATLAS_ASTEROIDS_5 = 8,
+    ATLAS_ASTEROIDS_6 = 9,
+    ATLAS_IMAGE_COUNT = 10
+};
@@ -0,0 +1,56 @@
+// Generated by tools/atlas_pack; do not edit. Regenerate with the `atlas` CMake target.
+#pragma once
+
+#include "atlas_index.h"
+
+#include <stdint.h>
+
+// Alpha >= 128 is solid. Rows top first, (width + 31) / 32 words each, with
+// pixel x in bit x % 32 of word x / 32. `radius` reaches every solid pixel
+// from the centre of the image.
+struct AtlasMask {
+    int image;
+    int width, height;
+    int offset;
+    float radius;
+};
+
+#define ATLAS_MASK_COUNT 8
+static const AtlasMask ATLAS_MASKS[ATLAS_MASK_COUNT] = {
+    {ATLAS_ROCKET_OFF, 32, 53, 0, 27.68f},
+    {ATLAS_ASTEROIDS_0, 19, 20, 53, 0.00f},
+    {ATLAS_ASTEROIDS_1, 19, 20, 73, 13.12f},
+    {ATLAS_ASTEROIDS_2, 19, 20, 93, 13.12f},
+    {ATLAS_ASTEROIDS_3, 19, 20, 113, 12.50f},
+    {ATLAS_ASTEROIDS_4, 19, 20, 133, 13.79f},
+    {ATLAS_ASTEROIDS_5, 19, 20, 153, 13.79f},
+    {ATLAS_ASTEROIDS_6, 19, 20, 173, 12.50f},
+};
+
+static const uint32_t ATLAS_MASK_BITS[193] = {
+    0x00ffff00, 0x00ffff00, 0x01ffff00, 0x01ffff00, 0x01ffff00, 0x01ffff80, 0x01ffffc0, 0x07ffffc0,
+    0x0fffffe0, 0x1ffffff8, 0x3ffffff8, 0x3ffffffc, 0x7ffffffc, 0x7ffffffe, 0x7ffffffe, 0x7ffffffe,
+    0x7ffffffe, 0x7ffffffe, 0x7ffffffe, 0xfffffffe, 0xffffffff, 0xffffffff, 0xffffffff, 0x3fffffff,
+    0x0ffffffc, 0x07ffffe0, 0x07fffff0, 0x07fffff0, 0x07fffff0, 0x07fffff0, 0x07fffff0, 0x01ffff80,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x0003fff8, 0x0003fffc, 0x0003fffc, 0x0003fffc, 0x0003fffe, 0x0003fffe, 0x0003fffe,
+    0x0003fffe, 0x0003fffc, 0x0003fff8, 0x0003fffc, 0x0003fffc, 0x0003fff8, 0x0000fff0, 0x00000e00,
+    0x00000000, 0x0000ffe0, 0x0000ffe0, 0x0001fff8, 0x0001fffc, 0x0003fffe, 0x0003fffe, 0x0007fffe,
+    0x0007ffff, 0x0007ffff, 0x0007ffff, 0x0007ffff, 0x0007ffff, 0x0007ffff, 0x0007ffff, 0x0003fffe,
+    0x0000fffe, 0x00000ffc, 0x000007f8, 0x000001e0, 0x00000000, 0x00000000, 0x000000c0, 0x000003f0,
+    0x00000ff8, 0x00001ffc, 0x00007ffc, 0x0001fffc, 0x0003fffe, 0x0003fffe, 0x0001fffe, 0x0001fffe,
+    0x0001fffe, 0x0003fffe, 0x0001fffe, 0x00003ffe, 0x00003ff8, 0x00001fe0, 0x00000f00, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x0007fffe, 0x0007fffe, 0x0007fffe,
+    0x0003fffe, 0x0003fffc, 0x0003fffc, 0x0001fffc, 0x0001fffe, 0x0001fff8, 0x0001fffc, 0x0003fff0,
+    0x0000fff8, 0x0000fbf0, 0x00003fc0, 0x000001c0, 0x00000000, 0x00000000, 0x0000def0, 0x0001fff8,
+    0x0003fffc, 0x0007fffc, 0x0007fffc, 0x0007fffc, 0x0007fffc, 0x0007fffc, 0x0003fffc, 0x0003fffe,
+    0x0001fff8, 0x0001fffc, 0x0000fff8, 0x0000fffc, 0x0001fff8, 0x00007de0, 0x00007fe0, 0x00000080,
+    0x00000000, 0x00000000, 0x00007f80, 0x0001fffc, 0x0001fffe, 0x0001fffc, 0x0001fffe, 0x0001ffff,
+    0x0003ffff, 0x0003fffe, 0x0003fffc, 0x0003fffe, 0x0001fffe, 0x0003fffe, 0x0003fffe, 0x0003fffc,
+    0x0003fff8, 0x0003ff80, 0x0000fc00, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000,
+};
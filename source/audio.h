@@ -0,0 +1,495 @@
+#pragma once
+
+#include "main.h"
+#include "memory.h"
+#include "mixer.h"
+
+#include <atomic>
+
+typedef struct {
+    u8* data;
+    u32 size;
+    u32 sampleRate;
+    u16 channels;
+    u16 bitsPerSample;
+} WavData;
+// Copies the PCM data of an in-memory WAV into linear memory.
+inline WavData parseWav(const u8* bytes, u32 size) {
+    WavData wav = {};
+
+    // Read WAV header (simplified - assumes PCM format)
+    if (size < 44) {
+        printf("WAV data too short\n");
+        return wav;
+    }
+    const u8* header = bytes;
+
+    // Parse header
+    wav.sampleRate = *(u32*)(header + 24);
+    wav.channels = *(u16*)(header + 22);
+    wav.bitsPerSample = *(u16*)(header + 34);
+    u32 dataSize = *(u32*)(header + 40);
+    if (dataSize > size - 44) {
+        dataSize = size - 44;
+    }
+
+    // Allocate buffer for audio data
+    wav.data = (u8*)trackedLinearAlloc(MEM_AUDIO, dataSize);
+    if (!wav.data) {
+        printf("Failed to allocate audio buffer\n");
+        return wav;
+    }
+
+    memcpy(wav.data, bytes + 44, dataSize);
+    wav.size = dataSize;
+    return wav;
+}
+inline WavData loadWav(const char* filename) {
+    FILE* file = fopen(filename, "rb");
+    if (!file) {
+        printf("Failed to open %s\n", filename);
+        return WavData{};
+    }
+    std::vector<u8> bytes;
+    u8 buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), file)) > 0) {
+        bytes.insert(bytes.end(), buf, buf + n);
+    }
+    fclose(file);
+    return parseWav(bytes.data(), bytes.size());
+}
+#define NDSP_CHANNEL_COUNT 24
+#define SOUNDBANK_MAX_SOUNDS 16
+#define SOUNDBANK_WAVEBUF_POOL 32
+
+struct Sound {
+    std::string path;
+    WavData wav;
+    u32 nsamples;
+    u16 format;
+    // Encoded WAV for sounds registered from memory; decoded on first use.
+    const u8* source = nullptr;
+    u32 sourceSize = 0;
+    u64 decodeTicks = 0;
+};
+
+// Decoded sounds stay resident in linear memory for the lifetime of the bank,
+// and playback borrows wave buffers from a fixed pool instead of allocating
+// one per hit. Sounds registered from memory (e.g. the asset archive) are
+// decoded by materialize(), which the game runs for all of them while it
+// loads; otherwise a sound is decoded the first time it is played. Every
+// allocation the bank makes is counted so the frame loop can check that
+// playing a preloaded sound costs nothing.
+class SoundBank {
+    std::vector<Sound> sounds;
+    ndspWaveBuf pool[SOUNDBANK_WAVEBUF_POOL];
+    int poolChannel[SOUNDBANK_WAVEBUF_POOL];
+    // A sound registered from memory is decoded by the loader thread, or by
+    // whichever thread plays it first if it was never materialized, while
+    // the render thread reads and resets the per-frame count.
+    std::atomic<u32> allocations{0};
+    std::atomic<u32> totalAllocations{0};
+
+    void adopt(Sound & sound, const WavData & wav) {
+        allocations.fetch_add(1, std::memory_order_relaxed);
+        totalAllocations.fetch_add(1, std::memory_order_relaxed);
+        DSP_FlushDataCache(wav.data, wav.size);
+        sound.wav = wav;
+        sound.nsamples = wav.size / (wav.channels * (wav.bitsPerSample / 8));
+        sound.format = NDSP_FORMAT_MONO_PCM16;
+        if (wav.channels == 2) {
+            sound.format = NDSP_FORMAT_STEREO_PCM16;
+        }
+    }
+public:
+    SoundBank() {
+        MemoryScope scope(MEM_AUDIO);
+        sounds.reserve(SOUNDBANK_MAX_SOUNDS);
+        memset(pool, 0, sizeof(pool));
+        for (int i = 0; i < SOUNDBANK_WAVEBUF_POOL; i++) {
+            poolChannel[i] = -1;
+        }
+    }
+    ~SoundBank() {
+        for (auto & sound : sounds) {
+            trackedLinearFree(MEM_AUDIO, sound.wav.data, sound.wav.size);
+        }
+    }
+    SoundBank(const SoundBank&) = delete;
+    SoundBank& operator=(const SoundBank&) = delete;
+
+    int find(const char* path) const {
+        for (int i = 0; i < (int)sounds.size(); i++) {
+            if (sounds[i].path == path) {
+                return i;
+            }
+        }
+        return -1;
+    }
+    int load(const char* path) {
+        MemoryScope scope(MEM_AUDIO);
+        int existing = find(path);
+        if (existing >= 0) return existing;
+        if (sounds.size() >= SOUNDBANK_MAX_SOUNDS) {
+            printf("Sound bank full, cannot load %s\n", path);
+            return -1;
+        }
+
+        WavData wav = loadWav(path);
+        if (!wav.data) return -1;
+
+        Sound sound;
+        sound.path = path;
+        sounds.push_back(sound);
+        adopt(sounds.back(), wav);
+        return sounds.size() - 1;
+    }
+    // Registers an encoded WAV that stays valid for the bank's lifetime.
+    int registerMemory(const char* name, const u8* data, u32 size) {
+        MemoryScope scope(MEM_AUDIO);
+        int existing = find(name);
+        if (existing >= 0) return existing;
+        if (sounds.size() >= SOUNDBANK_MAX_SOUNDS) {
+            printf("Sound bank full, cannot register %s\n", name);
+            return -1;
+        }
+        Sound sound;
+        sound.path = name;
+        sound.wav = WavData{};
+        sound.nsamples = 0;
+        sound.format = 0;
+        sound.source = data;
+        sound.sourceSize = size;
+        sounds.push_back(sound);
+        return sounds.size() - 1;
+    }
+    // Decodes a registered sound now instead of on first play.
+    bool materialize(int id) {
+        if (id < 0 || id >= (int)sounds.size()) return false;
+        Sound & sound = sounds[id];
+        if (sound.wav.data) return true;
+        if (!sound.source) return false;
+        u64 start = svcGetSystemTick();
+        WavData wav = parseWav(sound.source, sound.sourceSize);
+        if (!wav.data) return false;
+        adopt(sound, wav);
+        sound.decodeTicks = svcGetSystemTick() - start;
+        return true;
+    }
+    // Decodes every registered sound, so none is left for a first play.
+    bool materializeAll() {
+        bool ok = true;
+        for (int i = 0; i < (int)sounds.size(); i++) {
+            ok = materialize(i) && ok;
+        }
+        return ok;
+    }
+    const Sound* get(int id) {
+        if (!materialize(id)) return nullptr;
+        return &sounds[id];
+    }
+    const Sound* peek(int id) const {
+        if (id < 0 || id >= (int)sounds.size()) return nullptr;
+        return &sounds[id];
+    }
+
+    // Hands out a pooled buffer that the DSP has finished with, or nullptr if
+    // every buffer is still queued or playing.
+    ndspWaveBuf* acquire(int channel) {
+        for (int i = 0; i < SOUNDBANK_WAVEBUF_POOL; i++) {
+            if (pool[i].status == NDSP_WBUF_FREE || pool[i].status == NDSP_WBUF_DONE) {
+                memset(&pool[i], 0, sizeof(ndspWaveBuf));
+                poolChannel[i] = channel;
+                return &pool[i];
+            }
+        }
+        return nullptr;
+    }
+    // ndspChnWaveBufClear does not update the status of the buffers it drops,
+    // so they are returned to the pool by hand.
+    void releaseChannel(int channel) {
+        for (int i = 0; i < SOUNDBANK_WAVEBUF_POOL; i++) {
+            if (poolChannel[i] == channel) {
+                pool[i].status = NDSP_WBUF_FREE;
+                poolChannel[i] = -1;
+            }
+        }
+    }
+    int buffersInUse() const {
+        int used = 0;
+        for (int i = 0; i < SOUNDBANK_WAVEBUF_POOL; i++) {
+            if (pool[i].status == NDSP_WBUF_QUEUED || pool[i].status == NDSP_WBUF_PLAYING) {
+                used++;
+            }
+        }
+        return used;
+    }
+
+    void beginFrame() {
+        allocations.store(0, std::memory_order_relaxed);
+    }
+    u32 allocationsThisFrame() const {
+        return allocations.load(std::memory_order_relaxed);
+    }
+    u32 allocationsTotal() const {
+        return totalAllocations.load(std::memory_order_relaxed);
+    }
+};
+
+class AudioManager {
+private:
+    bool initialized = false;
+
+public:
+    SoundBank bank;
+
+    AudioManager() {
+        if (R_SUCCEEDED(ndspInit())) {
+            ndspSetOutputMode(NDSP_OUTPUT_STEREO);
+            initialized = true;
+            printf("Audio system initialized\n");
+        } else {
+            printf("Failed to initialize audio\n");
+        }
+    }
+
+    ~AudioManager() {
+        if (initialized) {
+            for (int channel = 0; channel < NDSP_CHANNEL_COUNT; channel++) {
+                ndspChnWaveBufClear(channel);
+            }
+            ndspExit();
+        }
+    }
+
+    // Decode a sound up front so the first play does not touch the file system.
+    int preload(const char* filename) {
+        return bank.load(filename);
+    }
+
+    void beginFrame() {
+        bank.beginFrame();
+    }
+
+    void play(int soundId, int channel = 0) {
+        if (!initialized) return;
+
+        const Sound* sound = bank.get(soundId);
+        if (!sound) return;
+
+        // Stop any existing audio on this channel
+        stopChannel(channel);
+
+        // Configure channel
+        ndspChnSetInterp(channel, NDSP_INTERP_LINEAR);
+        ndspChnSetRate(channel, sound->wav.sampleRate);
+        ndspChnSetFormat(channel, sound->format);
+
+        queue(soundId, channel);
+    }
+
+    // Queues a sound on a channel that has already been configured for it.
+    bool queue(int soundId, int channel) {
+        if (!initialized) return false;
+
+        const Sound* sound = bank.get(soundId);
+        if (!sound) return false;
+
+        ndspWaveBuf* waveBuf = bank.acquire(channel);
+        if (!waveBuf) return false;
+
+        waveBuf->data_vaddr = sound->wav.data;
+        waveBuf->nsamples = sound->nsamples;
+
+        ndspChnWaveBufAdd(channel, waveBuf);
+        return true;
+    }
+
+    // Plays a sound by path, loading it into the bank on first use.
+    void playWavFile(const char* filename, int channel = 0) {
+        int soundId = bank.find(filename);
+        if (soundId < 0) {
+            soundId = bank.load(filename);
+        }
+        play(soundId, channel);
+        if (DEBUG) {
+            printf("Started playing %s on channel %d\n", filename, channel);
+        }
+    }
+
+    void stopChannel(int channel) {
+        if (initialized) {
+            ndspChnWaveBufClear(channel);
+            bank.releaseChannel(channel);
+        }
+    }
+
+    bool isInitialized() const {
+        return initialized;
+    }
+
+    bool isChannelPlaying(int channel) {
+        return initialized && ndspChnIsPlaying(channel);
+    }
+
+    void setVolume(int channel, float volume) {
+        setMix(channel, volume, 0.0f);
+    }
+    // Volume plus a pan from -1 (left) to 1 (right).
+    void setMix(int channel, float volume, float pan) {
+        if (initialized) {
+            float mix[12] = {0};
+            panGains(volume, pan, mix[0], mix[1]); // Left and right speakers
+            ndspChnSetMix(channel, mix);
+        }
+    }
+};
+
+enum SoundPriority {
+    SOUND_PRIORITY_LOW = 0,
+    SOUND_PRIORITY_NORMAL = 1,
+    SOUND_PRIORITY_HIGH = 2,
+};
+
+// Spreads one-shot sounds across a range of NDSP channels. Each channel is
+// configured once up front and only has its rate/format touched again when a
+// sound with a different layout lands on it. When every voice is busy the
+// lowest-priority, oldest one is stolen; a sound never steals from a voice
+// with a higher priority than its own.
+//
+// With a SoftwareMixer attached, sounds go to the mixer instead. It has no
+// voice limit worth speaking of, so priorities no longer matter.
+class VoiceManager {
+    struct Voice {
+        int soundId = -1;
+        int priority = 0;
+        u32 startedAt = 0;
+        float rate = 0.0f;
+        u16 format = 0;
+        // Outside -1..1, so the first play on a voice sets its mix.
+        float pan = -2.0f;
+    };
+
+    AudioManager& am;
+    SoftwareMixer* mixer = nullptr;
+    Voice voices[NDSP_CHANNEL_COUNT];
+    int firstChannel, voiceCount;
+    u32 playCounter = 0;
+    u32 steals = 0, drops = 0;
+
+    bool isIdle(int voice) {
+        return voices[voice].soundId < 0 || !am.isChannelPlaying(firstChannel + voice);
+    }
+
+    int pickVoice(int priority) {
+        int victim = -1;
+        for (int i = 0; i < voiceCount; i++) {
+            if (isIdle(i)) {
+                return i;
+            }
+            if (voices[i].priority > priority) {
+                continue;
+            }
+            if (victim < 0 || voices[i].priority < voices[victim].priority ||
+                (voices[i].priority == voices[victim].priority && voices[i].startedAt < voices[victim].startedAt)) {
+                victim = i;
+            }
+        }
+        return victim;
+    }
+
+public:
+    VoiceManager(AudioManager & am_, int firstChannel_ = 0, int lastChannel = NDSP_CHANNEL_COUNT - 1)
+        : am(am_), firstChannel(firstChannel_), voiceCount(lastChannel - firstChannel_ + 1) {
+        for (int i = 0; i < voiceCount; i++) {
+            int channel = firstChannel + i;
+            am.stopChannel(channel);
+            if (am.isInitialized()) {
+                ndspChnSetInterp(channel, NDSP_INTERP_LINEAR);
+            }
+            am.setVolume(channel, 1.0f);
+        }
+    }
+
+    void setMixer(SoftwareMixer* mixer_) {
+        mixer = mixer_;
+    }
+
+    // Returns the channel the sound started on, or -1 if it was dropped.
+    // `pan` runs from -1 (left) to 1 (right).
+    int play(int soundId, int priority = SOUND_PRIORITY_NORMAL, float pan = 0.0f) {
+        const Sound* sound = am.bank.get(soundId);
+        if (!sound || !am.isInitialized()) return -1;
+        if (mixer) {
+            if (!mixer->play((const s16*)sound->wav.data, sound->nsamples, sound->wav.channels, sound->wav.sampleRate,
+                             1.0f, pan)) {
+                drops++;
+                return -1;
+            }
+            return mixer->outputChannel();
+        }
+
+        int voice = pickVoice(priority);
+        if (voice < 0) {
+            drops++;
+            return -1;
+        }
+
+        int channel = firstChannel + voice;
+        Voice & v = voices[voice];
+        if (v.soundId >= 0 && am.isChannelPlaying(channel)) {
+            steals++;
+        }
+        am.stopChannel(channel);
+
+        if (v.rate != sound->wav.sampleRate) {
+            ndspChnSetRate(channel, sound->wav.sampleRate);
+            v.rate = sound->wav.sampleRate;
+        }
+        if (v.format != sound->format) {
+            ndspChnSetFormat(channel, sound->format);
+            v.format = sound->format;
+        }
+
+        if (v.pan != pan) {
+            am.setMix(channel, 1.0f, pan);
+            v.pan = pan;
+        }
+
+        if (!am.queue(soundId, channel)) {
+            v.soundId = -1;
+            drops++;
+            return -1;
+        }
+        v.soundId = soundId;
+        v.priority = priority;
+        v.startedAt = playCounter++;
+        return channel;
+    }
+
+    void stopAll() {
+        for (int i = 0; i < voiceCount; i++) {
+            am.stopChannel(firstChannel + i);
+            voices[i].soundId = -1;
+        }
+    }
+
+    int activeVoices() {
+        int active = 0;
+        for (int i = 0; i < voiceCount; i++) {
+            if (!isIdle(i)) active++;
+        }
+        return active;
+    }
+    // Sounds started on NDSP channels; the mixer keeps its own count.
+    u32 playCount() const {
+        return playCounter;
+    }
+    u32 stealCount() const {
+        return steals;
+    }
+    u32 dropCount() const {
+        return drops;
+    }
+};
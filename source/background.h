@@ -0,0 +1,38 @@
+#pragma once
+
+#include "main.h"
+#include "batch.h"
+
+#define BACKGROUND_PARALLAX 0.5f
+
+class Background {
+    C2D_Sprite bg_sprite;
+    C2D_Image bg_image;
+    float realWidth, realHeight = 1.0f;
+public:
+    Background(int realWidth_, int realHeight_, C2D_SpriteSheet atlas, int image) {
+        this->realWidth = realWidth_;
+        this->realHeight = realHeight_;
+        C2D_SpriteFromSheet(&bg_sprite, atlas, image);
+        float scaleX = (TOP_WIDTH/realWidth), scaleY = (TOP_HEIGHT/realHeight);
+        C2D_SpriteSetScale(&bg_sprite, scaleX, scaleY);
+        std::cout << "\nScaling to " << scaleX << " x " << scaleY << " y ";
+
+    }
+    // The backdrop repeats every screen and scrolls at half the camera's
+    // speed, so it reads as far away. Up to four copies cover the view.
+    void draw(SpriteBatch & batch, float cameraX = 0, float cameraY = 0) {
+        float offsetX = -fmodf(cameraX * BACKGROUND_PARALLAX, TOP_WIDTH);
+        float offsetY = -fmodf(cameraY * BACKGROUND_PARALLAX, TOP_HEIGHT);
+        C2D_DrawParams params = bg_sprite.params;
+        for (int row = 0; row < 2; row++) {
+            for (int col = 0; col < 2; col++) {
+                params.pos.x = offsetX + col * TOP_WIDTH;
+                params.pos.y = offsetY + row * TOP_HEIGHT;
+                if (params.pos.x >= TOP_WIDTH || params.pos.y >= TOP_HEIGHT) continue;
+                batch.add(bg_sprite.image, params, LAYER_BACKGROUND);
+            }
+        }
+    }
+
+};
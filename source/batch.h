@@ -0,0 +1,91 @@
+#pragma once
+
+#include "main.h"
+#include "memory.h"
+#include "render_backend.h"
+
+enum SpriteLayer : u8 {
+    LAYER_BACKGROUND = 0,
+    LAYER_PLAYER = 1,
+    LAYER_ASTEROIDS = 2,
+    LAYER_EXPLOSIONS = 3,
+};
+
+#define SPRITE_BATCH_MAX_TEXTURES 16
+
+// Collects a scene's sprites and submits them to a backend sorted by layer
+// and then texture, so each texture is bound once per layer no matter what order
+// the game queued things in. Within a layer and texture, queue order is kept.
+// Capacity is fixed at construction; sprites past it are dropped and counted.
+class SpriteBatch {
+    struct Entry {
+        C2D_Image image;
+        C2D_DrawParams params;
+    };
+    std::vector<Entry> entries;
+    std::vector<u64> keys;
+    const C3D_Tex* textures[SPRITE_BATCH_MAX_TEXTURES];
+    int textureCount = 0;
+    u32 dropped = 0;
+    u32 lastSubmitted = 0, lastTextureSwitches = 0;
+
+    u32 textureSlot(const C3D_Tex* tex) {
+        for (int i = 0; i < textureCount; i++) {
+            if (textures[i] == tex) return i;
+        }
+        if (textureCount < SPRITE_BATCH_MAX_TEXTURES) {
+            textures[textureCount] = tex;
+            return textureCount++;
+        }
+        return SPRITE_BATCH_MAX_TEXTURES - 1;
+    }
+public:
+    explicit SpriteBatch(int capacity) {
+        MemoryScope scope(MEM_RENDER);
+        entries.reserve(capacity);
+        keys.reserve(capacity);
+    }
+
+    void add(const C2D_Image & image, const C2D_DrawParams & params, SpriteLayer layer) {
+        if (entries.size() == entries.capacity()) {
+            dropped++;
+            return;
+        }
+        // Key: layer, texture slot, then submission order in the low bits so
+        // an unstable sort still keeps queue order.
+        u64 key = ((u64)layer << 40) | ((u64)textureSlot(image.tex) << 32) | entries.size();
+        entries.push_back(Entry{image, params});
+        keys.push_back(key);
+    }
+    void add(const C2D_Sprite & sprite, SpriteLayer layer) {
+        add(sprite.image, sprite.params, layer);
+    }
+
+    void flush(RenderBackend & backend) {
+        std::sort(keys.begin(), keys.end());
+        const C3D_Tex* bound = nullptr;
+        lastTextureSwitches = 0;
+        for (u64 key : keys) {
+            const Entry & entry = entries[key & 0xFFFFFFFF];
+            if (entry.image.tex != bound) {
+                bound = entry.image.tex;
+                lastTextureSwitches++;
+            }
+            backend.drawImage(entry.image, entry.params);
+        }
+        lastSubmitted = entries.size();
+        entries.clear();
+        keys.clear();
+        textureCount = 0;
+    }
+
+    u32 submittedLastFlush() const {
+        return lastSubmitted;
+    }
+    u32 textureSwitchesLastFlush() const {
+        return lastTextureSwitches;
+    }
+    u32 droppedCount() const {
+        return dropped;
+    }
+};
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "main.h"
+#include "numeric.h"
+#include "memory.h"
+#include "atlas_masks.h"
+
+#define MASK_ROTATION_BITS 5
+#define MASK_ROTATIONS (1 << MASK_ROTATION_BITS)
+
+// A sprite's solid pixels at one rotation and scale, as packed rows of bits
+// in the same layout as atlas_masks.h. The mask is square and centred on
+// the sprite's position, so any rotation fits.
+struct CollisionMask {
+    int size = 0, wordsPerRow = 0;
+    std::vector<u32> bits;
+
+    // 32 columns of `row` starting at `column`, which may hang off either
+    // side; columns outside the mask read as empty.
+    u32 window(int row, int column) const {
+        const u32* words = bits.data() + row * wordsPerRow;
+        int word = column >> 5, shift = column & 31;
+        u64 low = word >= 0 && word < wordsPerRow ? words[word] : 0;
+        u64 high = word + 1 >= 0 && word + 1 < wordsPerRow ? words[word + 1] : 0;
+        return (u32)(((high << 32) | low) >> shift);
+    }
+};
+
+// Pixel-accurate overlap of two masks centred at (ax, ay) and (bx, by),
+// with positions rounded to whole pixels. Each row of b is ANDed a word at
+// a time against the matching 32 columns of a; the first overlap returns.
+inline bool masksOverlap(const CollisionMask & a, float ax, float ay, const CollisionMask & b, float bx, float by) {
+    float centring = (a.size - b.size) * 0.5f;
+    int offsetX = (int)floorf(ax - bx - centring + 0.5f);
+    int offsetY = (int)floorf(ay - by - centring + 0.5f);
+    int rowStart = std::max(0, offsetY), rowEnd = std::min(b.size, offsetY + a.size);
+    for (int row = rowStart; row < rowEnd; row++) {
+        const u32* words = b.bits.data() + row * b.wordsPerRow;
+        for (int w = 0; w < b.wordsPerRow; w++) {
+            if (words[w] & a.window(row - offsetY, w * 32 - offsetX)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// One atlas image's mask pre-rotated to MASK_ROTATIONS angles, plus the
+// radius of the circle that holds it, for a cheap reject before the masks.
+class CollisionShape {
+    CollisionMask rotations[MASK_ROTATIONS];
+    float bound = 0;
+
+    // Nearest-pixel rotation: each destination pixel centre is turned back
+    // into the source image, the same way the sprite is drawn.
+    static void rotate(const AtlasMask & src, float scale, Angle angle, CollisionMask & out) {
+        out.size = (int)ceilf(sqrtf(src.width * src.width + src.height * src.height) * scale) + 2;
+        out.wordsPerRow = (out.size + 31) / 32;
+        out.bits.assign(out.size * out.wordsPerRow, 0);
+        int srcWords = (src.width + 31) / 32;
+        float c = lutCos(angle), s = lutSin(angle), half = out.size * 0.5f;
+        for (int y = 0; y < out.size; y++) {
+            for (int x = 0; x < out.size; x++) {
+                float px = x + 0.5f - half, py = y + 0.5f - half;
+                int sx = (int)floorf((px * c + py * s) / scale + src.width * 0.5f);
+                int sy = (int)floorf((py * c - px * s) / scale + src.height * 0.5f);
+                if (sx < 0 || sy < 0 || sx >= src.width || sy >= src.height) continue;
+                if (ATLAS_MASK_BITS[src.offset + sy * srcWords + sx / 32] & (1u << (sx % 32))) {
+                    out.bits[y * out.wordsPerRow + x / 32] |= 1u << (x % 32);
+                }
+            }
+        }
+    }
+public:
+    void build(const AtlasMask & src, float scale) {
+        for (int i = 0; i < MASK_ROTATIONS; i++) {
+            rotate(src, scale, (Angle)(i << (16 - MASK_ROTATION_BITS)), rotations[i]);
+        }
+        // Nearest sampling can reach half a pixel past the scaled outline.
+        bound = src.radius * scale + 1;
+    }
+    const CollisionMask & at(Angle angle) const {
+        return rotations[(u16)(angle + (1 << (15 - MASK_ROTATION_BITS))) >> (16 - MASK_ROTATION_BITS)];
+    }
+    float radius() const {
+        return bound;
+    }
+};
+
+// Shapes for every masked atlas image, at the scale the game draws it. The
+// rocket body comes from the flameless image so the exhaust never hits.
+class CollisionShapes {
+    CollisionShape shapes[ATLAS_IMAGE_COUNT];
+public:
+    CollisionShapes() {
+        MemoryScope scope(MEM_COLLISION);
+        for (int i = 0; i < ATLAS_MASK_COUNT; i++) {
+            const AtlasMask & mask = ATLAS_MASKS[i];
+            shapes[mask.image].build(mask, mask.image == ATLAS_ROCKET_OFF ? PLAYER_SCALE : 1.0f);
+        }
+    }
+    const CollisionShape & shape(int image) const {
+        return shapes[image];
+    }
+    float largestRadius(int first, int count) const {
+        float largest = 0;
+        for (int i = first; i < first + count; i++) {
+            largest = std::max(largest, shapes[i].radius());
+        }
+        return largest;
+    }
+};
+
+// Built on first use; main() touches it at startup so that is at load time.
+inline const CollisionShapes & collisionShapes() {
+    static const CollisionShapes shapes;
+    return shapes;
+}
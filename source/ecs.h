@@ -0,0 +1,277 @@
+#pragma once
+
+#include "main.h"
+#include "pool.h"
+#include "simd.h"
+#include "snapshot.h"
+#include "animation.h"
+
+#include <tuple>
+
+// A small entity-component store. Each kind of entity lives in an
+// EntityTable holding one component struct per thing it has; every
+// component keeps its fields in their own dense arrays, all indexed by the
+// entity's dense index. Systems are free functions that take only the
+// components they read or write and make one linear pass over them. Each
+// index is handled on its own, so a system can be split into ranges and run
+// on several threads.
+//
+// Every component provides reserve(n), append() (one default element),
+// appendFrom(other, i) (a copy of another table's element i) and
+// removeSwap(i) (move the last element into i and drop the last), which is
+// all EntityTable needs.
+
+template<typename T>
+inline void removeSwapColumn(std::vector<T> & column, int i) {
+    column[i] = column.back();
+    column.pop_back();
+}
+
+// Position now and at the previous step, for interpolation; rotation is in
+// radians.
+struct Transform {
+    std::vector<float> x, y, prevX, prevY, rotation;
+
+    void reserve(int n) {
+        x.reserve(n);
+        y.reserve(n);
+        prevX.reserve(n);
+        prevY.reserve(n);
+        rotation.reserve(n);
+    }
+    void append() {
+        x.push_back(0);
+        y.push_back(0);
+        prevX.push_back(0);
+        prevY.push_back(0);
+        rotation.push_back(0);
+    }
+    void appendFrom(const Transform & other, int i) {
+        x.push_back(other.x[i]);
+        y.push_back(other.y[i]);
+        prevX.push_back(other.prevX[i]);
+        prevY.push_back(other.prevY[i]);
+        rotation.push_back(other.rotation[i]);
+    }
+    void removeSwap(int i) {
+        removeSwapColumn(x, i);
+        removeSwapColumn(y, i);
+        removeSwapColumn(prevX, i);
+        removeSwapColumn(prevY, i);
+        removeSwapColumn(rotation, i);
+    }
+    // Puts an entity at (x, y) with nothing to interpolate from.
+    void place(int i, float x_, float y_) {
+        x[i] = prevX[i] = x_;
+        y[i] = prevY[i] = y_;
+    }
+};
+
+// Pixels and radians per second.
+struct Velocity {
+    std::vector<float> x, y, spin;
+
+    void reserve(int n) {
+        x.reserve(n);
+        y.reserve(n);
+        spin.reserve(n);
+    }
+    void append() {
+        x.push_back(0);
+        y.push_back(0);
+        spin.push_back(0);
+    }
+    void appendFrom(const Velocity & other, int i) {
+        x.push_back(other.x[i]);
+        y.push_back(other.y[i]);
+        spin.push_back(other.spin[i]);
+    }
+    void removeSwap(int i) {
+        removeSwapColumn(x, i);
+        removeSwapColumn(y, i);
+        removeSwapColumn(spin, i);
+    }
+};
+
+// The atlas image an entity is drawn with.
+struct SpriteRef {
+    std::vector<u16> image;
+
+    void reserve(int n) {
+        image.reserve(n);
+    }
+    void append() {
+        image.push_back(0);
+    }
+    void appendFrom(const SpriteRef & other, int i) {
+        image.push_back(other.image[i]);
+    }
+    void removeSwap(int i) {
+        removeSwapColumn(image, i);
+    }
+};
+
+// A clip from animation.h and how far into it the entity is; drawn instead
+// of a SpriteRef.
+struct Animation {
+    std::vector<u8> clip;
+    std::vector<u32> step;
+
+    void reserve(int n) {
+        clip.reserve(n);
+        step.reserve(n);
+    }
+    void append() {
+        clip.push_back(0);
+        step.push_back(0);
+    }
+    void appendFrom(const Animation & other, int i) {
+        clip.push_back(other.clip[i]);
+        step.push_back(other.step[i]);
+    }
+    void removeSwap(int i) {
+        removeSwapColumn(clip, i);
+        removeSwapColumn(step, i);
+    }
+};
+
+// The collision shape (an atlas image with a mask, see collision_mask.h)
+// and the radius of its bounding circle.
+struct Collider {
+    std::vector<u16> shape;
+    std::vector<float> radius;
+
+    void reserve(int n) {
+        shape.reserve(n);
+        radius.reserve(n);
+    }
+    void append() {
+        shape.push_back(0);
+        radius.push_back(0);
+    }
+    void appendFrom(const Collider & other, int i) {
+        shape.push_back(other.shape[i]);
+        radius.push_back(other.radius[i]);
+    }
+    void removeSwap(int i) {
+        removeSwapColumn(shape, i);
+        removeSwapColumn(radius, i);
+    }
+};
+
+// Steps lived so far.
+struct Lifetime {
+    std::vector<int> frames;
+
+    void reserve(int n) {
+        frames.reserve(n);
+    }
+    void append() {
+        frames.push_back(0);
+    }
+    void appendFrom(const Lifetime & other, int i) {
+        frames.push_back(other.frames[i]);
+    }
+    void removeSwap(int i) {
+        removeSwapColumn(frames, i);
+    }
+};
+
+// Fixed-capacity table of entities that all have the same components. All
+// storage is reserved in the constructor. Removing swaps the last entity
+// into the hole, and handles follow it there (see pool.h).
+template<typename... Components>
+class EntityTable {
+    HandleTable handles;
+    std::tuple<Components...> components;
+    int size = 0;
+public:
+    explicit EntityTable(int capacity) : handles(capacity) {
+        std::apply([&](auto &... component) { (component.reserve(capacity), ...); }, components);
+    }
+
+    template<typename C>
+    C & get() {
+        return std::get<C>(components);
+    }
+    template<typename C>
+    const C & get() const {
+        return std::get<C>(components);
+    }
+
+    int count() const {
+        return size;
+    }
+    bool full() const {
+        return handles.full();
+    }
+
+    // Appends an entity with default components at index count() - 1 for
+    // the caller to fill in. The table must not be full.
+    EntityHandle add() {
+        std::apply([](auto &... component) { (component.append(), ...); }, components);
+        return handles.add(size++);
+    }
+    // Moves entity i to the end of `other`, which must not be full. It gets
+    // a new handle there; the old one goes stale.
+    EntityHandle transfer(int i, EntityTable & other) {
+        std::apply([&](auto &... component) { (component.appendFrom(get<std::decay_t<decltype(component)>>(), i), ...); },
+                   other.components);
+        EntityHandle handle = other.handles.add(other.size++);
+        remove(i);
+        return handle;
+    }
+    void remove(int i) {
+        handles.removeSwap(i, size - 1);
+        std::apply([&](auto &... component) { (component.removeSwap(i), ...); }, components);
+        size--;
+    }
+
+    // Dense index for a handle, or -1 if that entity is gone.
+    int indexOf(EntityHandle handle) const {
+        return handles.indexOf(handle);
+    }
+    EntityHandle handleAt(int i) const {
+        return handles.handleAt(i);
+    }
+};
+
+// Systems.
+
+inline void moveSystem(Transform & transform, const Velocity & velocity, int count, float dt) {
+    std::copy(transform.x.begin(), transform.x.begin() + count, transform.prevX.begin());
+    std::copy(transform.y.begin(), transform.y.begin() + count, transform.prevY.begin());
+    integrateAxis(transform.x.data(), velocity.x.data(), count, dt);
+    integrateAxis(transform.y.data(), velocity.y.data(), count, dt);
+    integrateAxis(transform.rotation.data(), velocity.spin.data(), count, dt);
+}
+
+inline void ageSystem(Lifetime & lifetime, int count) {
+    for (int i = 0; i < count; i++) {
+        lifetime.frames[i]++;
+    }
+}
+
+inline void animateSystem(Animation & animation, int count) {
+    const AnimationTable & table = animations();
+    for (int i = 0; i < count; i++) {
+        animation.step[i] = table.advance((AnimClip)animation.clip[i], animation.step[i]);
+    }
+}
+
+inline void spriteSystem(const Transform & transform, const SpriteRef & sprite, SpriteLayer layer, int count, RenderSnapshot & out) {
+    for (int i = 0; i < count; i++) {
+        out.add(sprite.image[i], layer, transform.prevX[i], transform.prevY[i], transform.x[i], transform.y[i],
+                transform.rotation[i]);
+    }
+}
+
+inline void animatedSpriteSystem(const Transform & transform, const Animation & animation, SpriteLayer layer, int count,
+                                 RenderSnapshot & out) {
+    const AnimationTable & table = animations();
+    for (int i = 0; i < count; i++) {
+        const AnimFrame & frame = table.frameAt((AnimClip)animation.clip[i], animation.step[i]);
+        out.add(frame.image, layer, transform.prevX[i], transform.prevY[i], transform.x[i], transform.y[i],
+                transform.rotation[i], 1.0f, frame.pivotX, frame.pivotY);
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "main.h"
+#include "memory.h"
+
+#define FRAME_ARENA_BYTES (32 * 1024)
+
+// Scratch memory that lives for one render frame. alloc() bumps a pointer
+// through a buffer allocated once at startup; the main loop calls reset()
+// right before C3D_FrameBegin, which frees everything at once. Only the
+// render thread may use it. When a frame asks for more than fits, alloc()
+// returns nullptr and the overflow is counted, so callers must cope with
+// that (usually by skipping what the scratch was for).
+class FrameArena {
+    u8* buffer;
+    size_t used = 0;
+    size_t highWater = 0;
+    u32 overflows = 0;
+public:
+    FrameArena() {
+        MemoryScope scope(MEM_FRAME_ARENA);
+        buffer = new u8[FRAME_ARENA_BYTES];
+    }
+    ~FrameArena() {
+        delete[] buffer;
+    }
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    void* alloc(size_t size, size_t align = 8) {
+        size_t start = (used + align - 1) & ~(align - 1);
+        if (start + size > FRAME_ARENA_BYTES) {
+            overflows++;
+            return nullptr;
+        }
+        used = start + size;
+        if (used > highWater) {
+            highWater = used;
+        }
+        return buffer + start;
+    }
+    template<typename T>
+    T* allocArray(size_t count) {
+        return (T*)alloc(count * sizeof(T), alignof(T));
+    }
+    void reset() {
+        used = 0;
+    }
+
+    size_t highWaterBytes() const {
+        return highWater;
+    }
+    u32 overflowCount() const {
+        return overflows;
+    }
+};
+
+inline FrameArena & frameArena() {
+    static FrameArena arena;
+    return arena;
+}
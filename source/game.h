@@ -0,0 +1,154 @@
+#pragma once
+
+#include "main.h"
+#include "audio.h"
+#include "player.h"
+#include "asteroids.h"
+#include "profiler.h"
+#include "snapshot.h"
+#include "random.h"
+#include "state_hash.h"
+#include "waves.h"
+#include "world.h"
+
+// Input for one simulation step. Edge bits (kDown/kUp) are delivered to the
+// first step that runs after they were read.
+struct InputFrame {
+    u32 kDown = 0;
+    u32 kHeld = 0;
+    u32 kUp = 0;
+    s16 dx = 0;
+    s16 dy = 0;
+};
+
+// Everything the simulation owns. step() advances it by exactly one fixed
+// timestep; snapshot() copies out what the renderer needs. Game never touches
+// citro2d, so it can run on its own thread.
+class Game {
+public:
+    // All gameplay randomness comes from here, so a seed plus the per-step
+    // input fully determines a run.
+    Rng rng;
+    Particles particles;
+    Player player;
+    Asteroids asteroids;
+    AsteroidExplosions explosions;
+    VoiceManager & voices;
+    WaveScheduler waves;
+    WorldStreamer world;
+    int asteroidLimit;
+    float currentDx = 0, currentDy = 0;
+    float boosterScale = 5.0f;
+    u64 steps = 0;
+
+    Game(int asteroidLimit_, u64 seed, VoiceManager & voices_, int explosionSound)
+        : rng(seed), particles(seed), player(WORLD_WIDTH / 2, WORLD_HEIGHT / 2), asteroids(asteroidLimit_, rng),
+          explosions(explosionCapacityFor(asteroidLimit_), rng), voices(voices_), world(seed), asteroidLimit(asteroidLimit_) {
+        asteroids.explosionSound = explosionSound;
+        player.exhaust = &particles;
+        explosions.debris = &particles;
+    }
+
+    // Hands the live asteroid count over to a stress test (see stress.h) and
+    // makes the player invulnerable so the run can't end early.
+    void enableStress(const std::atomic<int>* target) {
+        waves.setStressTarget(target);
+        player.invulnerable = true;
+    }
+
+    void step(const InputFrame & input, double dt) {
+        steps++;
+        // Waves fill the near chunks, entering at the edges of the view.
+        float cameraX, cameraY;
+        cameraFor(player.getPosition().first, player.getPosition().second, cameraX, cameraY);
+        int spawns = waves.step(asteroids.count(), asteroidLimit);
+        for (int i = 0; i < spawns; i++) {
+            asteroids.spawnAsteroid(waves.speedScale(), cameraX, cameraY);
+        }
+        {
+            PROFILE_SCOPE(PHASE_UPDATE);
+            player.update(dt);
+            asteroids.updateAsteroids(dt);
+        }
+        {
+            PROFILE_SCOPE(PHASE_COLLIDE);
+            asteroids.stream(world, player.getPosition().first, player.getPosition().second);
+            asteroids.asteroidsCollide(player, explosions, voices);
+        }
+        {
+            PROFILE_SCOPE(PHASE_EXPLOSIONS);
+            explosions.updateExplosions();
+            particles.update(dt);
+        }
+
+        if ((std::abs(input.dx) + std::abs(input.dy)) > 75) {
+            player.setHeading(lutAtan2(input.dy, -input.dx) - ANGLE_QUARTER);
+            currentDx = input.dx;
+            currentDy = input.dy;
+        }
+        if (input.kDown & KEY_A) {
+            player.applyForce((currentDx / 156.0f)*boosterScale, (-currentDy / 156.0f)*boosterScale);
+            player.booster(true);
+        } else if (input.kHeld & KEY_A) {
+            if (input.kHeld & KEY_R) {
+                if (player.fuel.burn(100.0, dt)) {
+                    boosterScale = 5.0f;
+                }else {
+                    boosterScale = 3.0;
+                }
+            }else {
+                boosterScale = 3.0f;
+            }
+
+            player.applyForce((currentDx / 156.0f)*boosterScale, (-currentDy / 156.0f)*boosterScale);
+
+        } else if (input.kUp & KEY_A) {
+            player.booster(false);
+        }
+        player.checkBounds();
+
+        player.fuel.recharge(50.0, dt);
+    }
+
+    // Particles are left out: they are cosmetic and never feed back into play.
+    u64 hashState() const {
+        StateHash hash;
+        hash.add(steps);
+        hash.add(rng.getState());
+        waves.hashState(hash);
+        hash.add(currentDx);
+        hash.add(currentDy);
+        hash.add(boosterScale);
+        player.hashState(hash);
+        world.hashState(hash);
+        asteroids.hashState(hash);
+        explosions.hashState(hash);
+        return hash.get();
+    }
+
+    void snapshot(RenderSnapshot & out) const {
+        out.clear();
+        player.snapshot(out);
+        asteroids.snapshotAsteroids(out);
+        explosions.snapshotExplosions(out);
+        particles.snapshotParticles(out);
+        out.hud.fuel = player.fuel.level();
+        out.hud.fuelColor = player.fuel.gaugeColor();
+        out.hud.health = player.health.level();
+        out.hud.seconds = steps / SIM_HZ;
+        out.hud.wave = waves.waveNumber();
+        out.asteroids = asteroids.count();
+        out.over = over();
+        cameraFor(player.getPosition().first, player.getPosition().second, out.cameraX, out.cameraY);
+        cameraFor(player.getPreviousPosition().first, player.getPreviousPosition().second, out.prevCameraX, out.prevCameraY);
+    }
+
+    // Upper bound on sprites snapshot() can write.
+    int spriteCapacity() const {
+        return 1 + asteroidLimit + explosionCapacityFor(asteroidLimit);
+    }
+
+    bool over() const {
+        return player.health.depleted;
+    }
+};
@@ -0,0 +1,124 @@
+#pragma once
+
+#include "main.h"
+
+// Uniform grid over a width x height area placed by setOrigin() (for the
+// asteroids, the streamed near area), rebuilt from scratch every frame with a
+// counting sort so that building is linear in the number of items and, once
+// the buffers have grown to the peak item count, allocation-free.
+class SpatialGrid {
+    int cols, rows;
+    float invCellSize;
+    float originX = 0, originY = 0;
+    std::vector<int> cellStart;
+    std::vector<int> cursor;
+    std::vector<int> items;
+    std::vector<int> itemCell;
+
+    int clampCol(int c) const {
+        return c < 0 ? 0 : (c >= cols ? cols - 1 : c);
+    }
+    int clampRow(int r) const {
+        return r < 0 ? 0 : (r >= rows ? rows - 1 : r);
+    }
+public:
+    SpatialGrid(float width, float height, float cellSize) : invCellSize(1.0f / cellSize) {
+        cols = (int)std::ceil(width / cellSize);
+        rows = (int)std::ceil(height / cellSize);
+        cellStart.resize(cols * rows + 1);
+        cursor.resize(cols * rows);
+    }
+
+    void reserve(int count) {
+        items.reserve(count);
+        itemCell.reserve(count);
+    }
+
+    // World position of the grid's top-left corner; items outside the grid
+    // are counted in its edge cells.
+    void setOrigin(float x, float y) {
+        originX = x;
+        originY = y;
+    }
+
+    int cellOf(float x, float y) const {
+        return clampRow((int)((y - originY) * invCellSize)) * cols + clampCol((int)((x - originX) * invCellSize));
+    }
+
+    void build(const float* x, const float* y, int count) {
+        items.resize(count);
+        itemCell.resize(count);
+        std::fill(cellStart.begin(), cellStart.end(), 0);
+        for (int i = 0; i < count; i++) {
+            itemCell[i] = cellOf(x[i], y[i]);
+            cellStart[itemCell[i] + 1]++;
+        }
+        for (int c = 0; c < cols * rows; c++) {
+            cellStart[c + 1] += cellStart[c];
+        }
+        std::copy(cellStart.begin(), cellStart.end() - 1, cursor.begin());
+        for (int i = 0; i < count; i++) {
+            items[cursor[itemCell[i]]++] = i;
+        }
+    }
+
+    // Calls visit(index) for every item in the cells a circle touches.
+    // Candidates still need a narrow-phase test.
+    template<typename Visit>
+    void query(float x, float y, float radius, Visit && visit) const {
+        x -= originX;
+        y -= originY;
+        int c0 = clampCol((int)((x - radius) * invCellSize)), c1 = clampCol((int)((x + radius) * invCellSize));
+        int r0 = clampRow((int)((y - radius) * invCellSize)), r1 = clampRow((int)((y + radius) * invCellSize));
+        for (int r = r0; r <= r1; r++) {
+            for (int c = c0; c <= c1; c++) {
+                int cell = r * cols + c;
+                for (int k = cellStart[cell]; k < cellStart[cell + 1]; k++) {
+                    visit(items[k]);
+                }
+            }
+        }
+    }
+
+    // Calls visit(a, b) once for every pair closer than minDist. minDist must
+    // not exceed the cell size, since only neighbouring cells are checked.
+    // At most maxPerCell items from each cell take part, which keeps the cost
+    // linear when a wave piles far more objects into a cell than can
+    // physically fit there. Returns how many items were left out that way,
+    // so callers can tell when pairs are being missed.
+    template<typename Visit>
+    int forEachPair(const float* x, const float* y, float minDist, int maxPerCell, Visit && visit) const {
+        const float minDistSq = minDist * minDist;
+        int skipped = 0;
+        // Own cell plus the four "forward" neighbours covers every adjacent
+        // pair exactly once.
+        const int offsets[4][2] = {{1, 0}, {-1, 1}, {0, 1}, {1, 1}};
+        for (int r = 0; r < rows; r++) {
+            for (int c = 0; c < cols; c++) {
+                int cell = r * cols + c;
+                int end = std::min(cellStart[cell + 1], cellStart[cell] + maxPerCell);
+                skipped += cellStart[cell + 1] - end;
+                for (int ka = cellStart[cell]; ka < end; ka++) {
+                    int a = items[ka];
+                    for (int kb = ka + 1; kb < end; kb++) {
+                        int b = items[kb];
+                        float dx = x[b] - x[a], dy = y[b] - y[a];
+                        if (dx * dx + dy * dy < minDistSq) visit(a, b);
+                    }
+                    for (auto & offset : offsets) {
+                        int nc = c + offset[0], nr = r + offset[1];
+                        if (nc < 0 || nc >= cols || nr >= rows) continue;
+                        int neighbour = nr * cols + nc;
+                        int neighbourEnd = std::min(cellStart[neighbour + 1], cellStart[neighbour] + maxPerCell);
+                        for (int kb = cellStart[neighbour]; kb < neighbourEnd; kb++) {
+                            int b = items[kb];
+                            float dx = x[b] - x[a], dy = y[b] - y[a];
+                            if (dx * dx + dy * dy < minDistSq) visit(a, b);
+                        }
+                    }
+                }
+            }
+        }
+        return skipped;
+    }
+};
@@ -0,0 +1,219 @@
+#pragma once
+
+#include "main.h"
+#include "snapshot.h"
+#include "memory.h"
+
+// Gauge colour for a level: green at 100 fading to red at 0. A full fuel tank
+// shows FUEL_FULL_COLOR instead.
+inline u32 gaugeColor(float level) {
+    return C2D_Color32f((255.0f-(level*2.55f))/255.0f, (level/100.0f), 0.0f, 1.0f);
+}
+#define FUEL_FULL_COLOR C2D_Color32(0, 0, 255, 255)
+
+class Fuel {
+    double amount = 100.0;
+    const double max = 150.0, min = 0;
+    u32 color = ::gaugeColor(amount);
+public:
+    int burn(float percent, float dt) {
+        if (amount - percent*dt < min) {
+            amount = 0;
+            return 0;
+        } else {
+            amount -= percent*dt;
+            return 1;
+        }
+    }
+    void recharge(double percent, double dt) {
+
+        if ((amount + (percent*dt)) >  max) {
+            color = FUEL_FULL_COLOR;
+            //std::cout << "\nMaxed (?) : " << (amount + (percent*dt) < 300.0) << " amount >> " << (amount + (percent*dt));
+        } else {
+            amount += percent*dt;
+            color = ::gaugeColor(amount);
+        }
+
+    }
+    double level() const {
+        return amount;
+    }
+    u32 gaugeColor() const {
+        return color;
+    }
+};
+class Health {
+    double amount = 100.0;
+public:
+    bool depleted = false;
+    int damage(float percent) {
+        if (amount - percent < 0) {
+            amount = 0;
+            depleted = true;
+            return 0;
+        } else {
+            amount -= percent;
+            return 1;
+        }
+    }
+
+    double level() const {
+        return amount;
+    }
+};
+
+// Text for values that change while playing. Each glyph in HUD_GLYPHS is
+// parsed once into the HUD's text buffer; a number is drawn as a row of
+// those, so nothing goes through C2D_TextParse per frame and the buffer
+// never grows. Advances are measured once and the digits share the widest
+// one, so numbers don't shift sideways as they count.
+#define HUD_GLYPHS "0123456789:"
+#define HUD_GLYPH_COUNT (sizeof(HUD_GLYPHS) - 1)
+
+class GlyphCache {
+    C2D_Text glyphs[HUD_GLYPH_COUNT];
+    float advances[HUD_GLYPH_COUNT];
+
+    int indexOf(char c) const {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c == ':') return 10;
+        return -1;
+    }
+public:
+    void build(C2D_TextBuf buf) {
+        char str[2] = {0, 0};
+        float digitWidth = 0;
+        for (size_t i = 0; i < HUD_GLYPH_COUNT; i++) {
+            str[0] = HUD_GLYPHS[i];
+            C2D_TextParse(&glyphs[i], buf, str);
+            C2D_TextOptimize(&glyphs[i]);
+            C2D_TextGetDimensions(&glyphs[i], 1.0f, 1.0f, &advances[i], nullptr);
+            if (i < 10 && advances[i] > digitWidth) digitWidth = advances[i];
+        }
+        for (int i = 0; i < 10; i++) {
+            advances[i] = digitWidth;
+        }
+    }
+
+    // Draws the cached glyphs for `str`, skipping any that aren't cached.
+    // Returns the width drawn.
+    float draw(const char* str, float x, float y, float scale, u32 color) const {
+        float start = x;
+        for (; *str; str++) {
+            int i = indexOf(*str);
+            if (i < 0) continue;
+            C2D_DrawText(&glyphs[i], C2D_WithColor, x, y, 1, scale, scale, color);
+            x += advances[i] * scale;
+        }
+        return x - start;
+    }
+
+    // `value` in decimal, zero-padded to at least minDigits.
+    float drawNumber(u32 value, int minDigits, float x, float y, float scale, u32 color) const {
+        char digits[11];
+        int n = 0;
+        do {
+            digits[n++] = '0' + value % 10;
+            value /= 10;
+        } while (value || n < minDigits);
+        char str[12];
+        for (int i = 0; i < n; i++) {
+            str[i] = digits[n - 1 - i];
+        }
+        str[n] = 0;
+        return draw(str, x, y, scale, color);
+    }
+
+    // `seconds` as m:ss.
+    float drawTime(u32 seconds, float x, float y, float scale, u32 color) const {
+        float width = drawNumber(seconds / 60, 1, x, y, scale, color);
+        width += draw(":", x + width, y, scale, color);
+        return width + drawNumber(seconds % 60, 2, x + width, y, scale, color);
+    }
+};
+
+// Draws the fuel and health gauges, the survival time and the wave number on
+// the bottom screen. Fuel and Health are simulation state; this only sees the values
+// copied out of a snapshot.
+//
+// The bottom screen keeps showing its last picture for as long as nothing
+// draws to it, so the HUD remembers what it last drew and needsRedraw() says
+// whether any of it would come out different. Gauges are compared at whole
+// pixels, so a value drifting by less than a pixel doesn't count.
+class Hud {
+    C2D_TextBuf textBuf;
+    C2D_Text boostText, integrityText, timeText, waveText;
+    GlyphCache glyphs;
+
+    struct Drawn {
+        int fuelWidth, healthWidth;
+        u32 fuelColor;
+        u32 seconds;
+        int wave;
+        bool operator==(const Drawn & other) const {
+            return fuelWidth == other.fuelWidth && healthWidth == other.healthWidth &&
+                   fuelColor == other.fuelColor && seconds == other.seconds && wave == other.wave;
+        }
+    };
+    Drawn drawn;
+    bool valid = false;
+
+    // The fuel gauge's colour is worked out again from its whole-pixel
+    // width, so it only changes when the width does (or the tank fills).
+    static Drawn quantize(const HudState & state) {
+        int fuel = (int)state.fuel;
+        u32 fuelColor = state.fuelColor == FUEL_FULL_COLOR ? FUEL_FULL_COLOR : gaugeColor(fuel);
+        return Drawn{fuel, (int)state.health, fuelColor, state.seconds, state.wave};
+    }
+public:
+    Hud() {
+        MemoryScope scope(MEM_HUD);
+        textBuf = C2D_TextBufNew(256);
+        C2D_TextBufClear(textBuf);
+        C2D_TextParse(&boostText, textBuf, "BOOST");
+        C2D_TextOptimize(&boostText);
+        C2D_TextParse(&integrityText, textBuf, "SHIP INTEGRITY");
+        C2D_TextOptimize(&integrityText);
+        C2D_TextParse(&timeText, textBuf, "TIME");
+        C2D_TextOptimize(&timeText);
+        C2D_TextParse(&waveText, textBuf, "WAVE");
+        C2D_TextOptimize(&waveText);
+        glyphs.build(textBuf);
+    }
+    ~Hud() {
+        C2D_TextBufDelete(textBuf);
+    }
+    Hud(const Hud&) = delete;
+    Hud& operator=(const Hud&) = delete;
+
+    bool needsRedraw(const HudState & state) const {
+        return !valid || !(quantize(state) == drawn);
+    }
+    // Forces the next needsRedraw() to say yes, e.g. after something else
+    // drew over the screen.
+    void invalidate() {
+        valid = false;
+    }
+
+    void draw(const HudState & state) {
+        drawn = quantize(state);
+        valid = true;
+
+        C2D_DrawRectSolid(10, TOP_HEIGHT*0.875, 1, drawn.fuelWidth-1, 10, drawn.fuelColor);
+        C2D_DrawText(&boostText, C2D_WithColor, 10, TOP_HEIGHT*0.79, 1, 0.5f, 0.5f, drawn.fuelColor);
+
+        float health = drawn.healthWidth;
+        u32 healthColor = gaugeColor(health);
+        C2D_DrawRectSolid(10, TOP_HEIGHT*0.675, 1, health-1, 10, healthColor);
+        C2D_DrawText(&integrityText, C2D_WithColor, 10, TOP_HEIGHT*0.594, 1, 0.5f, 0.5f, healthColor);
+
+        u32 white = C2D_Color32(255, 255, 255, 255);
+        C2D_DrawText(&timeText, C2D_WithColor, 10, 10, 1, 0.5f, 0.5f, white);
+        glyphs.drawTime(drawn.seconds, 10, 26, 0.75f, white);
+        if (drawn.wave > 0) {
+            C2D_DrawText(&waveText, C2D_WithColor, 100, 10, 1, 0.5f, 0.5f, white);
+            glyphs.drawNumber(drawn.wave, 1, 100, 26, 0.75f, white);
+        }
+    }
+};
@@ -0,0 +1,198 @@
+#pragma once
+
+#include "main.h"
+
+#include <atomic>
+
+#define LOADER_MAX_JOBS 16
+#define LOADER_THREAD_STACK (16 * 1024)
+#define LOADER_UPLOAD_BUDGET_MS 8.0f
+
+// One step of startup. `work` runs on the loader thread and does the slow
+// part: file reads, checksums, parsing. `upload` then runs on the render
+// thread for whatever has to touch the GPU. Either may be null; each
+// returns false if its part failed.
+typedef bool (*LoadFunc)(void* context);
+
+struct LoadJob {
+    const char* label;
+    LoadFunc work;
+    LoadFunc upload;
+    void* context;
+    bool failed;
+    u64 workTicks, uploadTicks;
+};
+
+// Runs a fixed list of load jobs while the main thread keeps drawing. The
+// loader thread works through the jobs in order and publishes each one by
+// bumping `worked` with release ordering. The render thread calls pump()
+// once a frame; it runs the uploads of jobs whose work is done, in the order
+// the jobs were added, until LOADER_UPLOAD_BUDGET_MS is used up, so the
+// loading screen keeps moving. A job's upload only runs after every earlier
+// job's work, so later jobs may depend on earlier ones.
+//
+// If the thread can't be started, pump() runs the work too, one job a
+// frame, which is slower but still shows progress.
+class AsyncLoader {
+    LoadJob jobs[LOADER_MAX_JOBS];
+    int count = 0;
+    std::atomic<int> worked{0};
+    int uploaded = 0;
+    Thread thread = nullptr;
+    bool started = false;
+
+    void runWork(LoadJob & job) {
+        u64 start = svcGetSystemTick();
+        if (job.work && !job.work(job.context)) {
+            job.failed = true;
+        }
+        job.workTicks = svcGetSystemTick() - start;
+        worked.store(worked.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    void run() {
+        for (int i = 0; i < count; i++) {
+            runWork(jobs[i]);
+        }
+    }
+
+    static void threadMain(void* arg) {
+        ((AsyncLoader*)arg)->run();
+    }
+
+    static float ticksToMs(u64 ticks) {
+        return ticks / (SYSCLOCK_ARM11 / 1000.0f);
+    }
+
+public:
+    AsyncLoader() {}
+    ~AsyncLoader() {
+        join();
+    }
+    AsyncLoader(const AsyncLoader&) = delete;
+    AsyncLoader& operator=(const AsyncLoader&) = delete;
+
+    // Jobs can only be added before start().
+    bool add(const char* label, LoadFunc work, LoadFunc upload, void* context) {
+        if (started || count == LOADER_MAX_JOBS) {
+            printf("Failed to add load job %s\n", label);
+            return false;
+        }
+        jobs[count++] = LoadJob{label, work, upload, context, false, 0, 0};
+        return true;
+    }
+
+    // The loader runs a step below the render thread, so it fills the time
+    // the render thread spends waiting for vblank.
+    void start() {
+        started = true;
+        s32 priority = 0x30;
+        svcGetThreadPriority(&priority, CUR_THREAD_HANDLE);
+        thread = threadCreate(threadMain, this, LOADER_THREAD_STACK, priority + 1, -2, false);
+        if (!thread) {
+            printf("Failed to start the loader thread; loading on the main thread\n");
+        }
+    }
+
+    // Render thread, once a frame. Returns true once every job is done.
+    bool pump() {
+        int done = worked.load(std::memory_order_acquire);
+        if (!thread && done < count) {
+            runWork(jobs[done]);
+            return false;
+        }
+        u64 frameStart = svcGetSystemTick();
+        while (uploaded < done && ticksToMs(svcGetSystemTick() - frameStart) < LOADER_UPLOAD_BUDGET_MS) {
+            LoadJob & job = jobs[uploaded++];
+            u64 start = svcGetSystemTick();
+            if (job.upload && !job.upload(job.context)) {
+                job.failed = true;
+            }
+            job.uploadTicks = svcGetSystemTick() - start;
+        }
+        if (uploaded == count) {
+            join();
+            return true;
+        }
+        return false;
+    }
+
+    // Finishes everything left without drawing in between, for when the
+    // app is closed while loading.
+    void finish() {
+        join();
+        while (!pump()) {
+        }
+    }
+
+    void join() {
+        if (thread) {
+            threadJoin(thread, U64_MAX);
+            threadFree(thread);
+            thread = nullptr;
+        }
+    }
+
+    // Each job counts twice, once for its work and once for its upload.
+    float progress() const {
+        if (count == 0) return 1;
+        return (worked.load(std::memory_order_acquire) + uploaded) / (2.0f * count);
+    }
+    // The job the loader is on, for the loading screen.
+    const char* currentLabel() const {
+        int done = worked.load(std::memory_order_acquire);
+        return done < count ? jobs[done].label : uploaded < count ? jobs[uploaded].label : "";
+    }
+
+    // Render thread, after pump() has returned true.
+    void report(FILE* out) const {
+        for (int i = 0; i < count; i++) {
+            fprintf(out, "  %-10s work %.2f ms, upload %.2f ms%s\n", jobs[i].label, ticksToMs(jobs[i].workTicks),
+                    ticksToMs(jobs[i].uploadTicks), jobs[i].failed ? "  FAILED" : "");
+        }
+    }
+};
+
+// Drawn on both screens while the loader runs: a spinning ring of dots on
+// the top screen, and a progress bar with the current job's name on the
+// bottom. It only uses solid shapes and its own small text buffer, so it
+// needs nothing that is still being loaded.
+#define LOADING_DOTS 8
+#define LOADING_TEXT_GLYPHS 64
+
+class LoadingScreen {
+    C2D_TextBuf textBuf;
+    u32 frames = 0;
+public:
+    LoadingScreen() {
+        textBuf = C2D_TextBufNew(LOADING_TEXT_GLYPHS);
+    }
+    ~LoadingScreen() {
+        C2D_TextBufDelete(textBuf);
+    }
+    LoadingScreen(const LoadingScreen&) = delete;
+    LoadingScreen& operator=(const LoadingScreen&) = delete;
+
+    void draw(C3D_RenderTarget* top, C3D_RenderTarget* bottom, float progress, const char* label) {
+        frames++;
+        C2D_TargetClear(top, C2D_Color32f(0.0f, 0.0f, 0.0f, 1.0f));
+        C2D_SceneBegin(top);
+        for (int i = 0; i < LOADING_DOTS; i++) {
+            float angle = (i * M_TAU) / LOADING_DOTS + frames * 0.08f;
+            u8 shade = 255 - ((i + frames / 4) % LOADING_DOTS) * (200 / LOADING_DOTS);
+            C2D_DrawRectSolid(TOP_WIDTH / 2 + cosf(angle) * 30 - 3, TOP_HEIGHT / 2 + sinf(angle) * 30 - 3, 0.5f, 6, 6,
+                              C2D_Color32(shade, shade, shade, 255));
+        }
+
+        C2D_TargetClear(bottom, C2D_Color32f(0.0f, 0.0f, 0.0f, 1.0f));
+        C2D_SceneBegin(bottom);
+        C2D_TextBufClear(textBuf);
+        C2D_Text title, stage;
+        C2D_TextParse(&title, textBuf, "LOADING");
+        C2D_TextParse(&stage, textBuf, label);
+        C2D_DrawText(&title, C2D_WithColor, 20, 80, 0.5f, 0.8f, 0.8f, C2D_Color32(255, 255, 255, 255));
+        C2D_DrawText(&stage, C2D_WithColor, 20, 150, 0.5f, 0.5f, 0.5f, C2D_Color32(160, 160, 160, 255));
+        C2D_DrawRectSolid(20, 120, 0.5f, 280, 20, C2D_Color32(40, 40, 50, 255));
+        C2D_DrawRectSolid(20, 120, 0.6f, 280 * progress, 20, C2D_Color32(60, 140, 255, 255));
+    }
+};
@@ -1,516 +1,38 @@
-#include <3ds.h>
-#include <stdio.h>
-#include <citro2d.h>
-#include <citro3d.h>
-#include <iostream>
-#include <3ds/os.h>
-#include <random>
-#include <malloc.h>
-#define TOP_WIDTH 400
-#define TOP_HEIGHT 240
-#define SAMPLERATE 44100
-#define DEBUG false
-
-#include <cmath>
-#include <stack>
-
-void printMemoryInfo() {
-    struct mallinfo mi = mallinfo();
-
-    printf("Heap memory info:\n");
-    printf("  Total allocated: %d bytes\n", mi.uordblks);
-    printf("  Total free: %d bytes\n", mi.fordblks);
-    printf("  Total heap size: %d bytes\n", mi.arena);
-}
-
-float circlepadToDegrees(float x, float y) {
-    // atan2 returns radians, convert to degrees
-    float angleRadians = atan2f(y, -x);
-    float angleDegrees = angleRadians * (180.0f / M_PI);
-
-    // atan2 returns -180 to +180, convert to 0-360 if needed
-    if (angleDegrees < 0) {
-        angleDegrees += 360.0f;
-    }
-    angleDegrees -= 90.0f;
-    return angleDegrees;
-}
-typedef struct {
-    u8* data;
-    u32 size;
-    u32 sampleRate;
-    u16 channels;
-    u16 bitsPerSample;
-} WavData;
-WavData loadWav(const char* filename) {
-    WavData wav = {0};
-
-    FILE* file = fopen(filename, "rb");
-    if (!file) {
-        printf("Failed to open %s\n", filename);
-        return wav;
-    }
-
-    // Read WAV header (simplified - assumes PCM format)
-    char header[44];
-    fread(header, 1, 44, file);
-
-    // Parse header
-    wav.sampleRate = *(u32*)(header + 24);
-    wav.channels = *(u16*)(header + 22);
-    wav.bitsPerSample = *(u16*)(header + 34);
-    u32 dataSize = *(u32*)(header + 40);
-
-    printf("Sample Rate: %lu Hz\n", wav.sampleRate);
-    printf("Channels: %u\n", wav.channels);
-    printf("Bits per sample: %u\n", wav.bitsPerSample);
-    printf("Data size: %lu bytes\n", dataSize);
-
-    // Allocate buffer for audio data
-    wav.data = (u8*)linearAlloc(dataSize);
-    if (!wav.data) {
-        printf("Failed to allocate audio buffer\n");
-        fclose(file);
-        return wav;
-    }
-
-    // Read audio data
-    fread(wav.data, 1, dataSize, file);
-    wav.size = dataSize;
-
-    fclose(file);
-    return wav;
-}
-class AudioManager {
-private:
-    bool initialized = false;
-
-public:
-    AudioManager() {
-        if (R_SUCCEEDED(ndspInit())) {
-            ndspSetOutputMode(NDSP_OUTPUT_STEREO);
-            initialized = true;
-            printf("Audio system initialized\n");
-        } else {
-            printf("Failed to initialize audio\n");
-        }
-    }
-
-    ~AudioManager() {
-        if (initialized) {
-            ndspExit();
-        }
-    }
-
-    void playWavFile(const char* filename, int channel = 0) {
-        if (!initialized) return;
-
-        WavData wav = loadWav(filename);
-        if (!wav.data) return;
-
-        // Stop any existing audio on this channel
-        ndspChnWaveBufClear(channel);
-
-        // Configure channel
-        ndspChnSetInterp(channel, NDSP_INTERP_LINEAR);
-        ndspChnSetRate(channel, wav.sampleRate);
-
-        // Set format based on channels and bit depth
-        u16 format = NDSP_FORMAT_MONO_PCM16;
-        if (wav.channels == 2) {
-            format = NDSP_FORMAT_STEREO_PCM16;
-        }
-        ndspChnSetFormat(channel, format);
-
-        // Create and queue wave buffer
-        ndspWaveBuf* waveBuf = new ndspWaveBuf;
-        memset(waveBuf, 0, sizeof(ndspWaveBuf));
-        waveBuf->data_vaddr = wav.data;
-        waveBuf->nsamples = wav.size / (wav.channels * (wav.bitsPerSample / 8));
-
-        ndspChnWaveBufAdd(channel, waveBuf);
-
-        printf("Started playing %s on channel %d\n", filename, channel);
-    }
-
-    void stopChannel(int channel) {
-        if (initialized) {
-            ndspChnWaveBufClear(channel);
-        }
-    }
-
-    bool isChannelPlaying(int channel) {
-        return initialized && ndspChnIsPlaying(channel);
-    }
-
-    void setVolume(int channel, float volume) {
-        if (initialized) {
-            float mix[12] = {0};
-            mix[0] = volume; // Left speaker
-            mix[1] = volume; // Right speaker
-            ndspChnSetMix(channel, mix);
-        }
-    }
-};
-
-class Timer {
-private:
-    u64 lastTime;
-public:
-    Timer() {
-        lastTime = osGetTime();
-    }
-
-    float getDeltaTime() {
-        u64 currentTime = osGetTime();
-        float deltaTime = (currentTime - lastTime) / 1000.0f; // Convert to seconds
-        lastTime = currentTime;
-        return deltaTime;
-    }
-};
-class Background {
-    C2D_Sprite bg_sprite;
-    C2D_Image bg_image;
-    float realWidth, realHeight = 1.0f;
-    const char* path;
-public:
-    Background(int realWidth_, int realHeight_, const char* path_) {
-        this->path = path_;
-        this->realWidth = realWidth_;
-        this->realHeight = realHeight_;
-        C2D_SpriteSheet sheet = C2D_SpriteSheetLoad(path);
-        C2D_SpriteFromSheet(&bg_sprite, sheet, 0);
-        float scaleX = (TOP_WIDTH/realWidth), scaleY = (TOP_HEIGHT/realHeight);
-        C2D_SpriteSetScale(&bg_sprite, scaleX, scaleY);
-        std::cout << "\nScaling to " << scaleX << " x " << scaleY << " y ";
-
-    }
-    void draw() {
-        C2D_DrawSprite(&bg_sprite);
-
-    }
-
-};
-class Fuel {
-    double amount = 100.0;
-    const double max = 150.0, min = 0;
-    u32 color = C2D_Color32f((255.0f-(amount*2.55f))/255.0f, (amount/100.0f), 0.0f, 1.0f);
-    C2D_Text text;
-    C2D_TextBuf textBuf;
-public:
-    Fuel() {
-        textBuf = C2D_TextBufNew(256);
-        C2D_TextBufClear(textBuf);
-        C2D_TextParse(&text, textBuf, "BOOST");
-        C2D_TextOptimize(&text);
-    }
-    int burn(float percent, float dt) {
-        if (amount - percent*dt < min) {
-            amount = 0;
-            return 0;
-        } else {
-            amount -= percent*dt;
-            return 1;
-        }
-    }
-    void recharge(double percent, double dt) {
-
-        if ((amount + (percent*dt)) >  max) {
-            color = C2D_Color32f(0, 0, 255, 1);
-            //std::cout << "\nMaxed (?) : " << (amount + (percent*dt) < 300.0) << " amount >> " << (amount + (percent*dt));
-        } else {
-            amount += percent*dt;
-            color = C2D_Color32f((255.0f-(amount*2.55f))/255.0f, (amount/100.0f), 0.0f, 1.0f);
-        }
-
-    }
-    void draw() {
-        C2D_DrawRectSolid(10, TOP_HEIGHT*0.875, 1, amount-1, 10, color);
-        C2D_DrawText(&text, C2D_WithColor, 10, TOP_HEIGHT*0.79, 1, 0.5f, 0.5f, color);
-    }
-};
-class Health {
-    double amount = 100.0;
-    C2D_Text text;
-    C2D_TextBuf textBuf;
-public:
-    bool depleted = false;
-    Health() {
-        textBuf = C2D_TextBufNew(256);
-        C2D_TextBufClear(textBuf);
-        C2D_TextParse(&text, textBuf, "SHIP INTEGRITY");
-        C2D_TextOptimize(&text);
-    }
-    int damage(float percent) {
-        if (amount - percent < 0) {
-            amount = 0;
-            depleted = true;
-            return 0;
-        } else {
-            amount -= percent;
-            return 1;
-        }
-    }
-
-    void draw() {
-        u32 color = C2D_Color32f((255.0f-(amount*2.55f))/255.0f, (amount/100.0f), 0.0f, 1.0f);
-        C2D_DrawRectSolid(10, TOP_HEIGHT*0.675, 1, amount-1, 10, color);
-        C2D_DrawText(&text, C2D_WithColor, 10, TOP_HEIGHT*0.594, 1, 0.5f, 0.5f, color);
-    }
-};
-class Player {
-    private:
-        const int imageWidth = 32, imageHeight = 53;
-        double x, y, xVel=0, yVel=0, xForce=0, yForce=0;
-        const float scale = 0.5f;
-        float rotation = 90.0f;
-        const int width = std::floor((float)32*scale);
-        const int height = std::floor((float)53*scale);
-        const char *offPath = "romfs:/rocket-off.t3x", *onPath = "romfs:/rocket-on.t3x";
-        C2D_Sprite sprite;
-        C2D_SpriteSheet sheetOn = C2D_SpriteSheetLoad(onPath);
-        C2D_SpriteSheet sheetOff = C2D_SpriteSheetLoad(offPath);
-    public:
-        Fuel fuel{};
-        Health health{};
-        Player(double x_, double y_) : x(x_), y(y_){
-            C2D_SpriteFromSheet(&sprite, sheetOn, 0);
-            C2D_SpriteSetPos(&sprite, x, y);
-            C2D_SpriteSetRotationDegrees(&sprite, rotation);
-            C2D_SpriteSetScale(&sprite, scale, scale);
-            C2D_SpriteSetCenter(&sprite, 0.5f, 0.5f);
-        }
-        void applyForce(double x_, double y_) {
-            xVel += x_;
-            yVel += y_;
-
-        }
-        void setRotation(double degrees_) {
-            rotation = degrees_;
-        }
-
-        void update(double dt) {
-            x += xVel*dt;
-            y += yVel*dt;
-            C2D_SpriteSetPos(&sprite, x, y);
-            C2D_SpriteSetRotationDegrees(&sprite, rotation);
-
-        }
-        std::pair<double, double> getPosition() {
-            return std::pair<double, double>(x, y);
-        }
-        float getRotation() const {
-            return rotation;
-        }
-        void draw() {
-                C2D_DrawSprite(&sprite);
-
-        }
-        void booster(bool on) {
-            if (on) {
-
-                C2D_SpriteFromSheet(&sprite, sheetOn, 0);
-            }else {
-                C2D_SpriteFromSheet(&sprite, sheetOff, 0);
-            }
-            C2D_SpriteSetPos(&sprite, x, y);
-            C2D_SpriteSetRotationDegrees(&sprite, rotation);
-            C2D_SpriteSetScale(&sprite, scale, scale);
-            C2D_SpriteSetCenter(&sprite, 0.5f, 0.5f);
-        }
-        void checkWrap() {
-            if (x > TOP_WIDTH) {
-                x = 0;
-            } else if (x < 0) {
-                x=TOP_WIDTH;
-            }if (y > TOP_HEIGHT) {
-                y = 0;
-            } else if (y < 0) {
-                y=TOP_HEIGHT;
-            }
-
-        }
-
-};
-
-class AsteroidExplosion {
-    double x, y;
-    float scale = 1.0f;
-
-    C2D_Sprite sprite;
-    C2D_SpriteSheet* spritesheet;
-public:
-    int frames = 0;
-    AsteroidExplosion(double x_, double y_,  C2D_SpriteSheet & spritesheet_) : x(x_), y(y_), spritesheet(&spritesheet_) {
-        C2D_SpriteSetScale(&sprite, scale, scale);
-        C2D_SpriteSetCenter(&sprite, 0.5f, 0.5f);
-        C2D_SpriteFromSheet(&sprite, *spritesheet, 5+(rand() % 2));
-        C2D_SpriteSetPos(&sprite, x, y);
-
-    }
-    void draw() {
-        C2D_DrawSprite(&sprite);
-    }
-
-};
-class AsteroidExplosions {
-    std::vector<AsteroidExplosion> explosions;
-    C2D_SpriteSheet* spritesheet;
-public:
-    AsteroidExplosions(C2D_SpriteSheet & spritesheet_) : spritesheet(&spritesheet_){}
-    void addExplosion(double x, double y) {
-        explosions.push_back(AsteroidExplosion(x, y, *spritesheet));
-    }
-    void drawExplosions() {
+#include "main.h"
+#include "audio.h"
+#include "music.h"
+#include "background.h"
+#include "hud.h"
+#include "player.h"
+#include "asteroids.h"
+#include "game.h"
+#include "batch.h"
+#include "atlas_index.h"
+#include "snapshot.h"
+#include "animation.h"
+#include "triple_buffer.h"
+#include "sim_thread.h"
+#include "replay.h"
+#include "assets.h"
+#include "waves.h"
+#include "stress.h"
+#include "profiler.h"
+#include "alloc_counter.h"
+#include "memory.h"
+#include "frame_arena.h"
+#include "loader.h"
+#include "collision_mask.h"
+#include <cassert>
+#include <cinttypes>
+#ifndef __3DS__
+#include "host_platform.h"
+#endif
 
-        for (auto & explosion : explosions) {
-            explosion.draw();
-        }
-    }
-    void updateExplosions() {
-        for (int i = explosions.size() - 1; i >= 0; i--) {
-            explosions[i].frames++;
-            if (explosions[i].frames > 20) {
-                explosions.erase(explosions.begin()+i);
-            }
-        }
-    }
-
-};
-
-class Asteroid {
-
-    double x, y, xVel=0, yVel=0;
-    float rotation = 0.0f;
-    float scale = 1.0f;
-    C2D_Sprite sprite;
-    C2D_SpriteSheet* spritesheet;
-
-public:
-    Asteroid(C2D_SpriteSheet spritesheet_) : spritesheet(&spritesheet_) {
-
-
-        char edge = rand() % 4;
-        if (edge == 0) {
-            x = 1;
-            y = rand() % TOP_HEIGHT;
-            xVel = rand() % 100;
-            yVel = (rand() % 200)-100;
-        } else if (edge == 1) {
-            x = rand() % TOP_WIDTH;
-            y = 1;
-            xVel = (rand() % 200)-100;
-            yVel = (rand() % 100);
-        }else if (edge == 2) {
-            x = TOP_WIDTH-1;
-            y = rand() % TOP_HEIGHT;
-            xVel = -(rand() % 100);
-            yVel = (rand() % 200)-100;
-        } else if (edge == 3) {
-            x = rand() % TOP_WIDTH;
-            y = TOP_HEIGHT-1;
-            xVel = (rand() % 200)-100;
-            yVel = -(rand() % 100);
-        }
-        C2D_SpriteSetScale(&sprite, scale, scale);
-        C2D_SpriteSetCenter(&sprite, 0.5f, 0.5f);
-        C2D_SpriteFromSheet(&sprite, *spritesheet, rand() % 3);
-    }
-    void spin(float degrees) {
-        rotation += degrees;
-        if (rotation > 360.0f) {
-            rotation = 360 - rotation;
-        }
-    }
-    void update(double dt) {
-        x += xVel*dt;
-        y += yVel*dt;
-        C2D_SpriteSetPos(&sprite, x, y);
-        C2D_SpriteSetRotationDegrees(&sprite, rotation);
-    }
-    void draw() {
-        C2D_DrawSprite(&sprite);
-    }
-    std::pair<double, double> getCoords() {
-        return std::pair<double, double>(x, y);
-    }
-    short int checkCollision(Player & player) {
-        if (x > TOP_WIDTH) {
-            return true;
-        }
-        if (x < 0) {
-            return true;
-        }
-        if (y > TOP_HEIGHT) {
-            return true;
-        }
-        if (y < 0) {
-            return true;
-        }
-        if (std::sqrt(std::pow((player.getPosition().first - x), 2) + std::pow((player.getPosition().second - y), 2)) < 17.5) {
-            player.health.damage(10.0);
-            return 2;
-        }
-        return false;
-    }
-};
-
-class Asteroids {
-public:
-    C2D_SpriteSheet spritesheet;
-    std::vector<Asteroid> asteroids;
-    int asteroidLimit = 0;
-    Asteroids(int asteroidLimit_) : asteroidLimit(asteroidLimit_) {
-        spritesheet = C2D_SpriteSheetLoad("romfs:/asteroids.t3x");
-        if (!spritesheet) {
-            printf("ERROR: Failed to load asteroids.t3x!\n");
-        } else {
-            printf("Asteroids sprite sheet loaded successfully!\n");
-        }
-    }
-    void spawnAsteroid() {
-        if (asteroids.size() < asteroidLimit) {
-            asteroids.push_back(Asteroid(spritesheet));
-        }
-    }
-    void drawAsteroids() {
-
-        for (auto & asteroid : asteroids) {
-            //asteroid.spin(5);
-            asteroid.draw();
-        }
-    }
-    void updateAsteroids(double dt) {
-        for (auto & asteroid : asteroids) {
-            asteroid.update(dt);
-        }
-    }
-    void asteroidsCollide(Player & player, AsteroidExplosions & explosions, AudioManager & am) {
-
-        for (int i = asteroids.size() - 1; i >= 0; i--) {
-            if (asteroids[i].checkCollision(player) == 1 || asteroids[i].checkCollision(player) == 2) {
-                if (asteroids[i].checkCollision(player) == 2) {
-                    am.playWavFile("romfs:/explosion.wav");
-                    explosions.addExplosion(asteroids[i].getCoords().first,asteroids[i].getCoords().second);
-
-                }
-                asteroids.erase(asteroids.begin() + i);
-                spawnAsteroid();
-
-            }
-
-        }
-        asteroids.shrink_to_fit();
-
-    }
-    void printAsteroids() {
-        for (int i=0; i<asteroids.size(); i++) {
-            std::cout << "\n Asteroid " << i << " | X: " << asteroids[i].getCoords().first << ", Y: "  << asteroids[i].getCoords().second;
-        }
-    }
-};
 int main(int argc, char* argv[])
 {
+    (void)argc;
+    (void)argv;
+    u64 bootTick = svcGetSystemTick();
     // Step 1: Basic initialization
     //printf("1. Initializing graphics...\n");
     gfxInitDefault();
@@ -525,13 +47,14 @@ int main(int argc, char* argv[])
     // printf("3. Initializing romfs...\n");
     Result rc = romfsInit();
     if (R_FAILED(rc)) {
-        printf("romfsInit failed: 0x%08lX\n", rc);
+        printf("romfsInit failed: 0x%08" PRIX32 "\n", (u32)rc);
     } else {
         //printf("romfs OK!\n");
     }
     //
     // printf("4. Initializing C3D...\n");
     bool c3d_ok = C3D_Init(C3D_DEFAULT_CMDBUF_SIZE);
+    (void)c3d_ok;
     // if (!c3d_ok) {
     //     printf("C3D_Init FAILED!\n");
     //     printf("Press START to exit\n");
@@ -548,7 +71,10 @@ int main(int argc, char* argv[])
     // printf("C3D OK!\n");
     //
     // printf("5. Initializing C2D...\n");
-    bool c2d_ok = C2D_Init(C2D_DEFAULT_MAX_OBJECTS);
+    // Every particle is one more solid rect on top of the usual objects, and
+    // a stress test can fill the screen with asteroids.
+    bool c2d_ok = C2D_Init(C2D_DEFAULT_MAX_OBJECTS + PARTICLE_BUDGET + STRESS_MAX_ASTEROIDS);
+    (void)c2d_ok;
     // if (!c2d_ok) {
     //     printf("C2D_Init FAILED!\n");
     //     printf("Press START to exit\n");
@@ -592,110 +118,373 @@ int main(int argc, char* argv[])
     // }
 
     AudioManager am;
-    Timer timer = Timer();
-    Background bg = Background(400, 240, "romfs:/space1.t3x");
-    Player player = Player(50, 50);
-    int asteroidLimit = 10;
-    Asteroids asteroidList(asteroidLimit);
-    AsteroidExplosions asteroidExplosionList{asteroidList.spritesheet};
-
-
-    float currentDx, currentDy;
-    float boosterScale = 5.0f;
-    int asteroidDelayFrames = 0;
-    bool spawnedAsteroids = false;
+    // The last channel is kept for the music stream, which starts first so
+    // it plays over the loading screen.
+    VoiceManager voices(am, 0, MUSIC_CHANNEL - 2);
+    // The channel below it belongs to the software mixer, when it is on.
+    SoftwareMixer mixer(MUSIC_CHANNEL - 1);
+    if (SOFTWARE_MIXER && mixer.start(am.isInitialized())) {
+        voices.setMixer(&mixer);
+    }
+    MusicStream music(am);
+    if (!music.start("romfs:/music.wav")) {
+        printf("Continuing without music...\n");
+    }
+    animations();
+    collisionShapes();
+    frameArena();
+
+    // Holding L at boot replays REPLAY_PLAY_PATH; otherwise the session is
+    // recorded to REPLAY_RECORD_PATH. The host build takes both paths from
+    // ROCKET_REPLAY / ROCKET_RECORD instead and only records when asked.
+    const char* replayPath = nullptr;
+    const char* recordPath = REPLAY_RECORD_PATH;
+    hidScanInput();
+    if (hidKeysHeld() & KEY_L) {
+        replayPath = REPLAY_PLAY_PATH;
+    }
+#ifndef __3DS__
+    replayPath = getenv("ROCKET_REPLAY");
+    recordPath = getenv("ROCKET_RECORD");
+#endif
+    // Holding R at boot (ROCKET_STRESS on the host) runs the stress test
+    // instead: asteroids keep coming until frames or simulation steps go over
+    // budget. It needs a PROFILE build, and is never recorded.
+    bool stressing = PROFILE && (hidKeysHeld() & KEY_R);
+#ifndef __3DS__
+    stressing = PROFILE && getenv("ROCKET_STRESS");
+#endif
+    // A host soak run (ROCKET_SOAK) keeps playing past the first game over:
+    // the player can't be hurt. Like the stress test it is never recorded.
+    bool soaking = false;
+#ifndef __3DS__
+    soaking = !stressing && getenv("ROCKET_SOAK");
+#endif
+    // Host runs steer the ship with hostScriptedInput, so what is recorded
+    // or profiled has play in it; ROCKET_HOST_SCRIPT=0 leaves it idle.
+    bool scripted = false;
+#ifndef __3DS__
+    const char* script = getenv("ROCKET_HOST_SCRIPT");
+    scripted = !script || atoi(script) != 0;
+#endif
+    if (soaking) {
+        replayPath = nullptr;
+        recordPath = nullptr;
+    }
+    if (stressing) {
+        replayPath = nullptr;
+        recordPath = nullptr;
+        printf("Stress test: raising the asteroid count until a frame takes over %.2f ms or a step over %.2f ms\n",
+               FRAME_BUDGET_MS, STEP_BUDGET_MS);
+    }
+
+    // Everything but the music comes from one archive read, which happens on
+    // the loader thread along with the checksums and the replay, while this
+    // thread keeps a loading screen moving. The atlas becomes a texture back
+    // on this thread. The explosion sound is only decoded when the first
+    // asteroid hits.
+    struct Startup {
+        AssetArchive assets;
+        SoundBank* bank;
+        InputReplay replay;
+        const char* replayPath;
+        bool replaying = false;
+        int explosionSound = -1;
+        C2D_SpriteSheet atlas = nullptr;
+    } startup;
+    startup.bank = &am.bank;
+    startup.replayPath = replayPath;
+    AsyncLoader loader;
+    loader.add("archive", [](void* c) {
+        Startup* s = (Startup*)c;
+        return s->assets.open(ASSET_ARCHIVE_PATH) && s->assets.verifyAll();
+    }, nullptr, &startup);
+    loader.add("sounds", [](void* c) {
+        Startup* s = (Startup*)c;
+        s->explosionSound = s->assets.sound("explosion", *s->bank);
+        // Decoded here rather than on the first hit, which would stall the
+        // simulation step that plays it.
+        return s->explosionSound >= 0 && s->bank->materializeAll();
+    }, nullptr, &startup);
+    loader.add("replay", [](void* c) {
+        Startup* s = (Startup*)c;
+        s->replaying = s->replayPath && s->replay.load(s->replayPath);
+        return !s->replayPath || s->replaying;
+    }, nullptr, &startup);
+    loader.add("atlas", nullptr, [](void* c) {
+        Startup* s = (Startup*)c;
+        s->atlas = s->assets.sheet(ATLAS_ASSET);
+        return s->atlas != nullptr;
+    }, &startup);
+    loader.start();
+
+    u64 firstFrameTicks = 0;
+    {
+        LoadingScreen loadingScreen;
+        while (!loader.pump()) {
+            if (!aptMainLoop()) {
+                loader.finish();
+                break;
+            }
+            C3D_FrameBegin(C3D_FRAME_SYNCDRAW);
+            loadingScreen.draw(top, bottom, loader.progress(), loader.currentLabel());
+            C3D_FrameEnd(0);
+            if (!firstFrameTicks) {
+                firstFrameTicks = svcGetSystemTick() - bootTick;
+            }
+        }
+    }
+
+#ifndef __3DS__
+    hostRestartFrameCount();
+#endif
+
+    AssetArchive & assets = startup.assets;
+    InputReplay & replay = startup.replay;
+    bool replaying = startup.replaying;
+    int explosionSound = startup.explosionSound;
+    C2D_SpriteSheet atlas = startup.atlas;
+    if (!atlas) {
+        printf("ERROR: Failed to load %s from %s!\n", ATLAS_ASSET, ASSET_ARCHIVE_PATH);
+    }
+    Background bg = Background(400, 240, atlas, ATLAS_SPACE1);
+    if (replaying) {
+        printf("Replaying %s (%lu steps)\n", replayPath, (unsigned long)replay.steps());
+#ifndef __3DS__
+        // A replay runs to its end however long that takes, so the check
+        // below never depends on how fast frames went by.
+        hostSetFrameLimit(UINT64_MAX);
+#endif
+    }
+
+    int asteroidLimit = replaying ? replay.asteroidLimit() : stressing ? STRESS_MAX_ASTEROIDS : WAVE_MAX_ASTEROIDS;
+    u64 seed = replaying ? replay.seed() : osGetTime();
+    Game game(asteroidLimit, seed, voices, explosionSound);
+    StressTest stress;
+    if (stressing) {
+        game.enableStress(stress.targetCount());
+    }
+    if (soaking) {
+        game.player.invulnerable = true;
+    }
+    InputRecorder recorder(seed, asteroidLimit);
+    // Up to four background tiles go in with the sprites.
+    SpriteBatch batch(game.spriteCapacity() + 4);
+    SnapshotRenderer renderer(atlas);
+    Citro2dBackend gpu;
+    Hud hud;
+
+    // The simulation runs on its own thread from here on; this thread only
+    // reads input, posts it to the mailbox and draws the newest snapshot.
+    InputMailbox mailbox;
+    TripleBuffer<RenderSnapshot> snapshots;
+    SimulationThread sim(game, mailbox, snapshots);
+    if (replaying) {
+        sim.setReplay(&replay);
+    } else if (recordPath) {
+        sim.setRecorder(&recorder);
+    }
+    bool simRunning = sim.start();
+
+    u64 frameNumber = 0;
+    u64 steadyStateAllocations = 0;
+    u64 interactiveTicks = 0;
+    u64 bottomRedraws = 0;
+    MemoryWatch* memoryWatch = nullptr;
+    u64 nextWatchStep = MEMORY_WATCH_STEPS;
     // Main loop - VERY simple
-    srand(osGetTime());
-    while (aptMainLoop())
+    while (simRunning && aptMainLoop())
     {
 
-        circlePosition pos;
-        hidCircleRead(&pos);
-        hidScanInput();
-        u32 kDown = hidKeysDown();
-        u32 kHeld = hidKeysHeld();
-        u32 kUp = hidKeysUp();
+        AllocationWatch frameAllocations;
+        ThreadAllocationWatch renderAllocations;
+        u32 kDown;
+        {
+            PROFILE_SCOPE(PHASE_INPUT);
+            circlePosition pos;
+#ifndef __3DS__
+            if (scripted) {
+                u32 held;
+                s16 dx, dy;
+                hostScriptedInput(frameNumber, &held, &dx, &dy);
+                hostSetInput(held, dx, dy);
+            }
+#endif
+            hidScanInput();
+            hidCircleRead(&pos);
+            kDown = hidKeysDown();
+            mailbox.post(kDown, hidKeysHeld(), hidKeysUp(), pos.dx, pos.dy);
+        }
         if (kDown & KEY_START) {
             printf("START pressed, exiting...\n");
             break;
         }
+        if (kDown & KEY_SELECT) {
+            frameProfiler().overlayVisible = !frameProfiler().overlayVisible;
+            hud.invalidate();
+        }
+        if (kDown & KEY_Y) {
+            frameProfiler().dumpCsv("sdmc:/rocketgame_profile.csv");
+        }
 
+        am.beginFrame();
+        snapshots.acquire();
+        const RenderSnapshot & snapshot = snapshots.readBuffer();
+        if (snapshot.over) {
+            break;
+        }
 
-
+        frameArena().reset();
         C3D_FrameBegin(C3D_FRAME_SYNCDRAW);
 
 
         C2D_TargetClear(top, C2D_Color32f(0.0f, 0.0f, 0.0f, 1.0f));
-        C2D_TargetClear(bottom, C2D_Color32f(0.0f, 0.0f, 0.0f, 1.0f));
 
-        C2D_SceneBegin(top);
-        asteroidDelayFrames++;
-        if (asteroidDelayFrames>240 && !spawnedAsteroids) {
-            for (int i=0; i<asteroidLimit; i++) {
-                asteroidList.spawnAsteroid();
-            }
-            spawnedAsteroids = true;
+        {
+            PROFILE_SCOPE(PHASE_DRAW_TOP);
+            C2D_SceneBegin(top);
+            float alpha = snapshot.alphaAt(svcGetSystemTick());
+            float cameraX, cameraY;
+            snapshot.cameraAt(alpha, cameraX, cameraY);
+            bg.draw(batch, cameraX, cameraY);
+            renderer.draw(snapshot, batch, alpha);
+            batch.flush(gpu);
+            renderer.drawParticles(snapshot, gpu, alpha);
         }
-        float dt = timer.getDeltaTime();
-        bg.draw();
-        player.update(dt);
-        asteroidList.updateAsteroids(dt);
-        asteroidList.asteroidsCollide(player, asteroidExplosionList, am);
-        asteroidExplosionList.updateExplosions();
-        player.draw();
-        asteroidList.drawAsteroids();
-        asteroidExplosionList.drawExplosions();
-
-        if ((std::abs(pos.dx) + std::abs(pos.dy)) > 75) {
-            player.setRotation(circlepadToDegrees(pos.dx, pos.dy));
-            currentDx= pos.dx;
-            currentDy = pos.dy;
-            //std::cout << "\nx " << pos.dx << " y " << pos.dy;
+
+        if (DEBUG) {
+            consoleClear();
+            printMemoryInfo();
+            printf("Audio allocations this frame: %lu\n", (unsigned long)am.bank.allocationsThisFrame());
+            printf("Music underruns: %lu\n", (unsigned long)music.underrunCount());
+            printf("Particles: %lu of %d\n", (unsigned long)snapshot.particles.size(), PARTICLE_BUDGET);
+            printMemoryReport(stdout);
         } else {
-            //std::cout << "\nIGNORING x " << pos.dx << " y " << pos.dy;
-        }
-        if (kDown & KEY_A) {
-            player.applyForce((currentDx / 156.0f)*boosterScale, (-currentDy / 156.0f)*boosterScale);
-            player.booster(true);
-        } else if (kHeld & KEY_A) {
-            if (kHeld & KEY_R) {
-                if (player.fuel.burn(100.0, dt)) {
-                    boosterScale = 5.0f;
-                }else {
-                    boosterScale = 3.0;
+            // The bottom screen is left alone unless the HUD changed. The
+            // profiler graph moves every frame, so while it is shown the
+            // screen is redrawn every frame.
+            PROFILE_SCOPE(PHASE_DRAW_BOTTOM);
+            bool overlay = PROFILE && frameProfiler().overlayVisible;
+            if (overlay || hud.needsRedraw(snapshot.hud)) {
+                C2D_TargetClear(bottom, C2D_Color32f(0.0f, 0.0f, 0.0f, 1.0f));
+                C2D_SceneBegin(bottom);
+                hud.draw(snapshot.hud);
+                if (overlay) {
+                    frameProfiler().drawOverlay(170, 140, 140, 80);
                 }
-            }else {
-                boosterScale = 3.0f;
+                bottomRedraws++;
             }
+        }
 
-            player.applyForce((currentDx / 156.0f)*boosterScale, (-currentDy / 156.0f)*boosterScale);
 
-        } else if (kUp & KEY_A) {
-            player.booster(false);
+        {
+            PROFILE_SCOPE(PHASE_FRAME_END);
+            C3D_FrameEnd(0);
         }
-        player.checkWrap();
-
-        if (DEBUG) {
-            consoleClear();
-            printMemoryInfo();
-        } else {
-            C2D_SceneBegin(bottom);
-            player.fuel.draw();
-            player.health.draw();
-            if (player.health.depleted) {
+        frameProfiler().endFrame();
+        if (frameNumber == 0) {
+            interactiveTicks = svcGetSystemTick() - bootTick;
+            if (!firstFrameTicks) {
+                firstFrameTicks = interactiveTicks;
+            }
+            // Usage after the first frame is the baseline the soak check
+            // compares against.
+            static MemoryWatch watch;
+            memoryWatch = &watch;
+        } else if (snapshot.step >= nextWatchStep) {
+            // Sampled by simulation steps: an unthrottled host draws many
+            // frames per step.
+            memoryWatch->sample();
+            nextWatchStep = snapshot.step - snapshot.step % MEMORY_WATCH_STEPS + MEMORY_WATCH_STEPS;
+        }
+        if (stressing) {
+            stress.frameFinished(frameProfiler().lastFrameIntervalMs(), FrameProfiler::ticksToMs(snapshot.stepCostTicks),
+                                 snapshot.asteroids);
+            if (stress.finished()) {
                 break;
             }
         }
 
+        // Everything the loop needs is sized at startup; after the first
+        // frame has warmed up lazily created state the loop must not touch
+        // the heap. The total covers every thread; the check only this one,
+        // so the simulation, loader or music threads can't trip it.
+        if (frameNumber++ > 0) {
+            steadyStateAllocations += frameAllocations.count();
+            if (DEBUG) {
+                assert(renderAllocations.count() == 0);
+            }
+        }
 
+    }
 
-        player.fuel.recharge(50.0, dt);
-
+    sim.stop();
+    mixer.stop();
 
-        C3D_FrameEnd(0);
+    // The game is back on this thread, so it can be hashed directly.
+    u64 finalHash = game.hashState();
+    printf("Final state hash: %016llx after %llu steps\n", (unsigned long long)finalHash, (unsigned long long)game.steps);
+    bool replayFailed = false;
+    if (replayPath && !replaying) {
+        printf("Replay %s could not be loaded\n", replayPath);
+        replayFailed = true;
+    } else if (replaying && !replay.finished()) {
+        printf("Replay did not finish (%lu of %lu steps)\n", (unsigned long)replay.playedSteps(), (unsigned long)replay.steps());
+        replayFailed = true;
+    } else if (replaying) {
+        if (!replay.expectedHash()) {
+            printf("Replay finished; the recording has no final hash to check\n");
+        } else {
+            replayFailed = replay.expectedHash() != finalHash;
+            printf("Replay %s: expected %016llx\n", replayFailed ? "MISMATCH" : "matches", (unsigned long long)replay.expectedHash());
+        }
+    } else if (!replaying && recordPath) {
+        if (recorder.save(recordPath, finalHash)) {
+            printf("Recorded %lu steps to %s%s\n", (unsigned long)recorder.steps(), recordPath, recorder.isTruncated() ? " (truncated)" : "");
+        }
+    }
 
+#ifndef __3DS__
+    if (PROFILE && getenv("ROCKET_PROFILE_CSV")) {
+        frameProfiler().dumpCsv(stdout);
     }
+#endif
 
+    if (stressing) {
+        stress.report(stdout);
+    }
+    printf("Particles: peak %d of %d, %lu dropped\n", game.particles.peakCount(), PARTICLE_BUDGET, (unsigned long)game.particles.droppedCount());
+    printf("Music underruns: %lu (%lu chunks streamed)\n", (unsigned long)music.underrunCount(), (unsigned long)music.chunksStreamed());
+    if (SOFTWARE_MIXER) {
+        printf("Mixer: peak %lu voices, %lu dropped, %lu cut off, %lu underruns, %.3f ms per chunk\n",
+               (unsigned long)mixer.peakVoices(), (unsigned long)(mixer.dropCount() + mixer.rejectCount()),
+               (unsigned long)mixer.stealCount(), (unsigned long)mixer.underrunCount(), mixer.chunkMs());
+    } else {
+        printf("Voices: %lu sounds played, %lu dropped, %lu cut off\n", (unsigned long)voices.playCount(),
+               (unsigned long)voices.dropCount(), (unsigned long)voices.stealCount());
+    }
+    printf("World: %lu chunks created, %lu evicted, %d live; %d far asteroids, %lu dropped\n",
+           (unsigned long)game.world.createdCount(), (unsigned long)game.world.evictedCount(), game.world.liveCount(),
+           game.asteroids.farCount(), (unsigned long)game.asteroids.droppedCount());
+    printf("Collisions: %lu asteroids left out of bounce tests in crowded cells\n",
+           (unsigned long)game.asteroids.crowdedCount());
+    printf("Culled off-screen: %llu of %llu sprites, %llu of %llu particles\n", (unsigned long long)renderer.culledSprites(),
+           (unsigned long long)renderer.spriteCount(), (unsigned long long)renderer.culledParticles(),
+           (unsigned long long)renderer.particleCount());
+    printf("Bottom screen redrawn on %llu of %llu frames\n", (unsigned long long)bottomRedraws, (unsigned long long)frameNumber);
+    printf("Cold start: first frame after %.2f ms, interactive after %.2f ms\n", FrameProfiler::ticksToMs(firstFrameTicks),
+           FrameProfiler::ticksToMs(interactiveTicks));
+    printf("Loading:\n");
+    loader.report(stdout);
+    assets.report(stdout, am.bank);
+    printf("Heap allocations after the first frame: %llu\n", (unsigned long long)steadyStateAllocations);
+    printMemoryReport(stdout);
+    printf("Frame arena: %lu of %d bytes at most, %lu overflows\n", (unsigned long)frameArena().highWaterBytes(),
+           FRAME_ARENA_BYTES, (unsigned long)frameArena().overflowCount());
+    if (memoryWatch) {
+        printf("Leak check: %s after %lu samples over %llu steps\n", memoryWatch->leakFound() ? "FAILED" : "clean",
+               (unsigned long)memoryWatch->sampleCount(), (unsigned long long)game.steps);
+    }
     printf("Cleanup starting...\n");
 
     printf("C2D_Fini...\n");
@@ -711,5 +500,5 @@ int main(int argc, char* argv[])
     gfxExit();
 
     printf("=== DEBUG COMPLETE ===\n");
-    return 0;
+    return replayFailed ? 1 : 0;
 }
\ No newline at end of file
@@ -1 +1,46 @@
+#pragma once
 
+#include <3ds.h>
+#include <stdio.h>
+#include <citro2d.h>
+#include <citro3d.h>
+#include <iostream>
+#include <3ds/os.h>
+#include <random>
+#include <malloc.h>
+#define TOP_WIDTH 400
+#define TOP_HEIGHT 240
+#define PLAYER_SCALE 0.5f
+#define SAMPLERATE 44100
+// Fixed simulation steps per second (see FixedTimestep in timer.h).
+#define SIM_HZ 60
+#define DEBUG false
+#ifndef PROFILE
+#define PROFILE true
+#endif
+// Mix sound effects in software onto one channel (mixer.h) instead of
+// giving each its own NDSP channel.
+#ifndef SOFTWARE_MIXER
+#define SOFTWARE_MIXER true
+#endif
+
+#include <cmath>
+#include <stack>
+#include <vector>
+#include <algorithm>
+#include <string>
+#include <cstring>
+
+inline void printMemoryInfo() {
+    // glibc deprecates mallinfo() for mallinfo2(), which newlib doesn't have.
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    struct mallinfo2 mi = mallinfo2();
+#else
+    struct mallinfo mi = mallinfo();
+#endif
+
+    printf("Heap memory info:\n");
+    printf("  Total allocated: %ld bytes\n", (long)mi.uordblks);
+    printf("  Total free: %ld bytes\n", (long)mi.fordblks);
+    printf("  Total heap size: %ld bytes\n", (long)mi.arena);
+}
@@ -0,0 +1,152 @@
+#pragma once
+
+#include "main.h"
+
+// Who owns a block of memory. Heap blocks take the tag of the thread's
+// current MemoryScope when they are allocated; linear and texture memory is
+// tagged explicitly by whoever allocates it.
+enum MemTag : u8 {
+    MEM_UNTAGGED,
+    MEM_AUDIO,
+    MEM_MUSIC,
+    MEM_ASSETS,
+    MEM_ASTEROIDS,
+    MEM_EXPLOSIONS,
+    MEM_PARTICLES,
+    MEM_HUD,
+    MEM_RENDER,
+    MEM_REPLAY,
+    MEM_FRAME_ARENA,
+    MEM_COLLISION,
+    MEM_TAG_COUNT
+};
+
+enum MemKind : u8 {
+    MEM_HEAP,
+    MEM_LINEAR,
+    MEM_TEXTURE,
+    MEM_KIND_COUNT
+};
+
+inline const char* memTagName(int tag) {
+    static const char* names[MEM_TAG_COUNT] = {
+        "untagged", "audio", "music", "assets", "asteroids", "explosions", "particles", "hud", "render", "replay", "frame_arena", "collision"
+    };
+    return names[tag];
+}
+inline const char* memKindName(int kind) {
+    static const char* names[MEM_KIND_COUNT] = {"heap", "linear", "texture"};
+    return names[kind];
+}
+
+struct MemoryUsage {
+    s64 live;
+    s64 peak;
+};
+
+// Defined in alloc_counter.cpp next to the operator new that feeds them.
+// Safe to call from any thread.
+void memoryTrack(MemTag tag, MemKind kind, s64 bytes);
+MemoryUsage memoryUsage(MemTag tag, MemKind kind);
+MemTag currentMemoryTag();
+void setCurrentMemoryTag(MemTag tag);
+
+// Tags the heap allocations made on this thread while it is alive, e.g. at
+// the top of a subsystem's constructor.
+class MemoryScope {
+    MemTag previous;
+public:
+    explicit MemoryScope(MemTag tag) : previous(currentMemoryTag()) {
+        setCurrentMemoryTag(tag);
+    }
+    ~MemoryScope() {
+        setCurrentMemoryTag(previous);
+    }
+    MemoryScope(const MemoryScope&) = delete;
+    MemoryScope& operator=(const MemoryScope&) = delete;
+};
+
+inline void* trackedLinearAlloc(MemTag tag, size_t size) {
+    void* mem = linearAlloc(size);
+    if (mem) {
+        memoryTrack(tag, MEM_LINEAR, size);
+    }
+    return mem;
+}
+inline void trackedLinearFree(MemTag tag, void* mem, size_t size) {
+    if (mem) {
+        memoryTrack(tag, MEM_LINEAR, -(s64)size);
+        linearFree(mem);
+    }
+}
+
+// One line per tag that has ever held anything: live and peak bytes of
+// each kind.
+inline void printMemoryReport(FILE* out) {
+    fprintf(out, "Memory by subsystem (live / peak KB):\n");
+    for (int tag = 0; tag < MEM_TAG_COUNT; tag++) {
+        MemoryUsage usage[MEM_KIND_COUNT];
+        bool used = false;
+        for (int kind = 0; kind < MEM_KIND_COUNT; kind++) {
+            usage[kind] = memoryUsage((MemTag)tag, (MemKind)kind);
+            used = used || usage[kind].peak > 0;
+        }
+        if (!used) continue;
+        fprintf(out, "  %-11s", memTagName(tag));
+        for (int kind = 0; kind < MEM_KIND_COUNT; kind++) {
+            fprintf(out, "  %s %.1f/%.1f", memKindName(kind), usage[kind].live / 1024.0, usage[kind].peak / 1024.0);
+        }
+        fprintf(out, "\n");
+    }
+}
+
+#define MEMORY_WATCH_STEPS 600
+#define MEMORY_LEAK_WINDOWS 3
+
+// Soak-test leak check. sample() is called every MEMORY_WATCH_STEPS
+// simulation steps, so it follows game time however fast frames are drawn;
+// a tag whose live bytes of some kind grow in MEMORY_LEAK_WINDOWS samples in
+// a row is reported. Memory that is created lazily once (a sound decoded on
+// its first hit) grows in one window and is not a leak; something allocated
+// per event keeps growing and is.
+class MemoryWatch {
+    s64 last[MEM_TAG_COUNT][MEM_KIND_COUNT];
+    u8 streak[MEM_TAG_COUNT][MEM_KIND_COUNT];
+    u32 samples = 0;
+    bool leaked = false;
+public:
+    MemoryWatch() {
+        memset(streak, 0, sizeof(streak));
+        for (int tag = 0; tag < MEM_TAG_COUNT; tag++) {
+            for (int kind = 0; kind < MEM_KIND_COUNT; kind++) {
+                last[tag][kind] = memoryUsage((MemTag)tag, (MemKind)kind).live;
+            }
+        }
+    }
+
+    // Returns false the first time a leak is seen.
+    bool sample() {
+        samples++;
+        bool ok = true;
+        for (int tag = 0; tag < MEM_TAG_COUNT; tag++) {
+            for (int kind = 0; kind < MEM_KIND_COUNT; kind++) {
+                s64 live = memoryUsage((MemTag)tag, (MemKind)kind).live;
+                streak[tag][kind] = live > last[tag][kind] ? streak[tag][kind] + 1 : 0;
+                if (streak[tag][kind] == MEMORY_LEAK_WINDOWS) {
+                    printf("Memory leak? %s %s grew for %d checks in a row, now %lld bytes\n", memTagName(tag),
+                           memKindName(kind), MEMORY_LEAK_WINDOWS, (long long)live);
+                    leaked = true;
+                    ok = false;
+                }
+                last[tag][kind] = live;
+            }
+        }
+        return ok;
+    }
+    bool leakFound() const {
+        return leaked;
+    }
+    u32 sampleCount() const {
+        return samples;
+    }
+};
@@ -0,0 +1,242 @@
+#pragma once
+
+#include "main.h"
+#include "memory.h"
+#include "simd.h"
+
+#include <atomic>
+
+#define MIXER_SAMPLE_RATE SAMPLERATE
+#define MIXER_MAX_VOICES 64
+#define MIXER_QUEUE_SIZE 64
+#define MIXER_BUFFER_COUNT 4
+#define MIXER_CHUNK_FRAMES 512
+#define MIXER_PCM_BYTES (MIXER_BUFFER_COUNT * MIXER_CHUNK_FRAMES * 4)
+#define MIXER_POLL_NS 4000000LL
+#define MIXER_THREAD_STACK (16 * 1024)
+
+// Left and right gain for a volume and a pan from -1 (left) to 1 (right).
+// The centre keeps both sides at full volume, as setVolume() does.
+inline void panGains(float volume, float pan, float & left, float & right) {
+    if (pan < -1) pan = -1;
+    if (pan > 1) pan = 1;
+    left = volume * (pan > 0 ? 1 - pan : 1);
+    right = volume * (pan < 0 ? 1 + pan : 1);
+}
+
+inline s16 toQ15(float gain) {
+    if (gain <= 0) return 0;
+    if (gain >= 1) return 32767;
+    return (s16)(gain * 32767);
+}
+
+// One sound being mixed, from PCM16 that stays resident while it plays.
+struct MixVoice {
+    const s16* data;
+    u32 frames, position;
+    u8 channels;
+    s16 gainL, gainR;
+};
+
+// Sums any number of one-shot sounds into a single stereo NDSP channel, so
+// overlapping effects don't each need a channel of their own. play() may be
+// called from one thread (the game thread); it pushes onto a lock-free
+// queue. A mixer thread drains the queue, mixes MIXER_CHUNK_FRAMES at a
+// time into a ring of wave buffers with the saturating kernels in simd.h,
+// and keeps the ring topped up like MusicStream does.
+//
+// Sounds must already be 16-bit PCM at MIXER_SAMPLE_RATE; the mixer does
+// not resample, and play() turns anything else down. Past MIXER_MAX_VOICES
+// the oldest voice is cut off. Four buffers of 512 frames put ~46 ms
+// between play() and the speaker.
+class SoftwareMixer {
+    int channel;
+    s16* pcm = nullptr;
+    ndspWaveBuf buffers[MIXER_BUFFER_COUNT];
+    MixVoice voices[MIXER_MAX_VOICES];
+    int active = 0;
+    MixVoice queue[MIXER_QUEUE_SIZE];
+    std::atomic<u32> queueHead{0}, queueTail{0};
+    Thread thread = nullptr;
+    std::atomic<bool> running{false}, primed{false};
+    std::atomic<u32> underruns{0}, drops{0}, steals{0}, rejects{0}, peak{0}, chunks{0};
+    std::atomic<u64> mixTicks{0};
+
+    void admit(const MixVoice & voice) {
+        if (active == MIXER_MAX_VOICES) {
+            memmove(voices, voices + 1, sizeof(MixVoice) * (MIXER_MAX_VOICES - 1));
+            active--;
+            steals.fetch_add(1, std::memory_order_relaxed);
+        }
+        voices[active++] = voice;
+    }
+
+    void service() {
+        // Also lets the host stand-in retire the buffers it has played.
+        ndspChnIsPlaying(channel);
+        int queued = 0;
+        for (int i = 0; i < MIXER_BUFFER_COUNT; i++) {
+            if (buffers[i].status == NDSP_WBUF_QUEUED || buffers[i].status == NDSP_WBUF_PLAYING) {
+                queued++;
+            }
+        }
+        if (queued == 0 && primed) {
+            underruns.fetch_add(1, std::memory_order_relaxed);
+        }
+        for (int i = 0; i < MIXER_BUFFER_COUNT; i++) {
+            if (buffers[i].status == NDSP_WBUF_FREE || buffers[i].status == NDSP_WBUF_DONE) {
+                s16* dst = pcm + i * MIXER_CHUNK_FRAMES * 2;
+                u64 start = svcGetSystemTick();
+                mix(dst, MIXER_CHUNK_FRAMES);
+                mixTicks.fetch_add(svcGetSystemTick() - start, std::memory_order_relaxed);
+                chunks.fetch_add(1, std::memory_order_relaxed);
+
+                ndspWaveBuf & buf = buffers[i];
+                memset(&buf, 0, sizeof(ndspWaveBuf));
+                buf.data_vaddr = dst;
+                buf.nsamples = MIXER_CHUNK_FRAMES;
+                DSP_FlushDataCache(dst, MIXER_CHUNK_FRAMES * 4);
+                ndspChnWaveBufAdd(channel, &buf);
+            }
+        }
+        primed = true;
+    }
+
+    static void threadMain(void* arg) {
+        SoftwareMixer* mixer = (SoftwareMixer*)arg;
+        while (mixer->running) {
+            mixer->service();
+            svcSleepThread(MIXER_POLL_NS);
+        }
+    }
+
+public:
+    explicit SoftwareMixer(int channel_) : channel(channel_) {
+        pcm = (s16*)trackedLinearAlloc(MEM_AUDIO, MIXER_PCM_BYTES);
+        if (!pcm) {
+            printf("Failed to allocate mixer buffers\n");
+        }
+        memset(buffers, 0, sizeof(buffers));
+    }
+    ~SoftwareMixer() {
+        stop();
+        trackedLinearFree(MEM_AUDIO, pcm, MIXER_PCM_BYTES);
+    }
+    SoftwareMixer(const SoftwareMixer&) = delete;
+    SoftwareMixer& operator=(const SoftwareMixer&) = delete;
+
+    // `audioReady` is whether NDSP came up; without it play() still queues
+    // but nothing is heard.
+    bool start(bool audioReady) {
+        if (!audioReady || !pcm) return false;
+        ndspChnWaveBufClear(channel);
+        ndspChnSetInterp(channel, NDSP_INTERP_LINEAR);
+        ndspChnSetRate(channel, MIXER_SAMPLE_RATE);
+        ndspChnSetFormat(channel, NDSP_FORMAT_STEREO_PCM16);
+        setVolume(1.0f);
+        memset(buffers, 0, sizeof(buffers));
+
+        // Same priority as the music stream, above the game thread.
+        s32 priority = 0x30;
+        svcGetThreadPriority(&priority, CUR_THREAD_HANDLE);
+        running = true;
+        thread = threadCreate(threadMain, this, MIXER_THREAD_STACK, priority - 1, -2, false);
+        if (!thread) {
+            printf("Failed to start the mixer thread\n");
+            running = false;
+            return false;
+        }
+        return true;
+    }
+
+    void stop() {
+        if (thread) {
+            running = false;
+            threadJoin(thread, U64_MAX);
+            threadFree(thread);
+            thread = nullptr;
+            ndspChnWaveBufClear(channel);
+        }
+    }
+
+    // Queues a sound; it starts in the next chunk the mixer thread mixes.
+    bool play(const s16* data, u32 frames, u8 channels, u32 sampleRate, float volume = 1.0f, float pan = 0.0f) {
+        if (!data || sampleRate != MIXER_SAMPLE_RATE || channels < 1 || channels > 2) {
+            rejects.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        u32 tail = queueTail.load(std::memory_order_relaxed);
+        if (tail - queueHead.load(std::memory_order_acquire) == MIXER_QUEUE_SIZE) {
+            drops.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        float left, right;
+        panGains(volume, pan, left, right);
+        queue[tail % MIXER_QUEUE_SIZE] = MixVoice{data, frames, 0, channels, toQ15(left), toQ15(right)};
+        queueTail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Mixes the next `frames` stereo frames of every voice into `out`. Only
+    // the mixer thread calls this once started; the benchmark calls it
+    // directly.
+    void mix(s16* out, int frames) {
+        u32 head = queueHead.load(std::memory_order_relaxed);
+        u32 tail = queueTail.load(std::memory_order_acquire);
+        for (; head != tail; head++) {
+            admit(queue[head % MIXER_QUEUE_SIZE]);
+        }
+        queueHead.store(head, std::memory_order_release);
+        if ((u32)active > peak.load(std::memory_order_relaxed)) {
+            peak.store(active, std::memory_order_relaxed);
+        }
+
+        memset(out, 0, frames * 4);
+        int kept = 0;
+        for (int v = 0; v < active; v++) {
+            MixVoice & voice = voices[v];
+            int n = std::min<u32>(frames, voice.frames - voice.position);
+            if (voice.channels == 2) {
+                mixStereoPcm16(out, voice.data + voice.position * 2, n, voice.gainL, voice.gainR);
+            } else {
+                mixMonoPcm16(out, voice.data + voice.position, n, voice.gainL, voice.gainR);
+            }
+            voice.position += n;
+            if (voice.position < voice.frames) {
+                voices[kept++] = voice;
+            }
+        }
+        active = kept;
+    }
+
+    void setVolume(float volume) {
+        float mix[12] = {0};
+        mix[0] = volume;
+        mix[1] = volume;
+        ndspChnSetMix(channel, mix);
+    }
+
+    int outputChannel() const {
+        return channel;
+    }
+    u32 peakVoices() const {
+        return peak.load(std::memory_order_relaxed);
+    }
+    u32 dropCount() const {
+        return drops.load(std::memory_order_relaxed);
+    }
+    u32 stealCount() const {
+        return steals.load(std::memory_order_relaxed);
+    }
+    u32 rejectCount() const {
+        return rejects.load(std::memory_order_relaxed);
+    }
+    u32 underrunCount() const {
+        return underruns.load(std::memory_order_relaxed);
+    }
+    // Average time the mixer thread spent on one chunk.
+    float chunkMs() const {
+        u32 n = chunks.load(std::memory_order_relaxed);
+        return n ? mixTicks.load(std::memory_order_relaxed) / (SYSCLOCK_ARM11 / 1000.0f) / n : 0;
+    }
+};
@@ -0,0 +1,229 @@
+#pragma once
+
+#include "main.h"
+#include "audio.h"
+
+#include <atomic>
+
+#define MUSIC_CHANNEL (NDSP_CHANNEL_COUNT - 1)
+#define MUSIC_BUFFER_COUNT 4
+#define MUSIC_CHUNK_SAMPLES 4096
+#define MUSIC_PCM_BYTES (MUSIC_BUFFER_COUNT * MUSIC_CHUNK_SAMPLES * 4)
+#define MUSIC_POLL_NS 10000000LL
+#define MUSIC_THREAD_STACK (16 * 1024)
+
+// Plays a long WAV without loading it: the file is read a chunk at a time into
+// a small ring of wave buffers in linear memory, and a dedicated thread tops
+// the ring up as the DSP finishes each buffer. The game thread only starts and
+// stops the stream, so it never waits on romfs.
+//
+// With 4 buffers of 4096 samples the DSP has ~280 ms of audio queued at
+// 44.1 kHz. If the refill thread is starved for longer than that the channel
+// runs dry; each time that happens is counted as an underrun.
+class MusicStream {
+    AudioManager& am;
+    int channel;
+    FILE* file = nullptr;
+    long dataStart = 0;
+    u32 dataSize = 0, dataRead = 0;
+    u32 sampleRate = 0;
+    u16 format = 0, frameBytes = 0;
+    bool loop = true;
+    u8* pcm = nullptr;
+    ndspWaveBuf buffers[MUSIC_BUFFER_COUNT];
+    Thread thread = nullptr;
+    std::atomic<bool> running{false}, finished{false}, primed{false};
+    std::atomic<u32> underruns{0}, chunks{0};
+
+    // Walks the RIFF chunks to the PCM data, leaving the file positioned on it.
+    bool openWav(const char* path) {
+        file = fopen(path, "rb");
+        if (!file) {
+            printf("Failed to open %s\n", path);
+            return false;
+        }
+        char riff[12];
+        if (fread(riff, 1, 12, file) != 12 || memcmp(riff, "RIFF", 4) || memcmp(riff + 8, "WAVE", 4)) {
+            printf("%s is not a WAV file\n", path);
+            return false;
+        }
+        u16 channels = 0, bitsPerSample = 0;
+        char header[8];
+        while (fread(header, 1, 8, file) == 8) {
+            u32 size = *(u32*)(header + 4);
+            if (!memcmp(header, "fmt ", 4)) {
+                u8 fmt[16];
+                if (size < 16 || fread(fmt, 1, 16, file) != 16) break;
+                channels = *(u16*)(fmt + 2);
+                sampleRate = *(u32*)(fmt + 4);
+                bitsPerSample = *(u16*)(fmt + 14);
+                fseek(file, (size - 16) + (size & 1), SEEK_CUR);
+            } else if (!memcmp(header, "data", 4)) {
+                dataStart = ftell(file);
+                dataSize = size;
+                break;
+            } else {
+                fseek(file, size + (size & 1), SEEK_CUR);
+            }
+        }
+        if (!dataSize || bitsPerSample != 16 || channels < 1 || channels > 2) {
+            printf("%s: only 16-bit mono or stereo PCM can be streamed\n", path);
+            return false;
+        }
+        format = channels == 2 ? NDSP_FORMAT_STEREO_PCM16 : NDSP_FORMAT_MONO_PCM16;
+        frameBytes = channels * 2;
+        dataRead = 0;
+        return true;
+    }
+
+    void closeFile() {
+        if (file) {
+            fclose(file);
+            file = nullptr;
+        }
+    }
+
+    // Reads up to maxBytes of PCM, wrapping to the start of the data when
+    // looping. Returns the number of bytes read.
+    u32 read(u8* dst, u32 maxBytes) {
+        u32 total = 0;
+        while (total < maxBytes) {
+            if (dataRead >= dataSize) {
+                if (!loop) break;
+                fseek(file, dataStart, SEEK_SET);
+                dataRead = 0;
+            }
+            u32 want = std::min(maxBytes - total, dataSize - dataRead);
+            u32 got = fread(dst + total, 1, want, file);
+            total += got;
+            dataRead += got;
+            if (got < want) {
+                dataRead = dataSize;
+                if (!loop) break;
+            }
+        }
+        return total;
+    }
+
+    bool fill(int index) {
+        u32 chunkBytes = MUSIC_CHUNK_SAMPLES * frameBytes;
+        u8* dst = pcm + index * chunkBytes;
+        u32 bytes = read(dst, chunkBytes);
+        if (bytes < frameBytes) return false;
+
+        ndspWaveBuf& buf = buffers[index];
+        memset(&buf, 0, sizeof(ndspWaveBuf));
+        buf.data_vaddr = dst;
+        buf.nsamples = bytes / frameBytes;
+        DSP_FlushDataCache(dst, bytes);
+        ndspChnWaveBufAdd(channel, &buf);
+        chunks++;
+        return true;
+    }
+
+    void service() {
+        // Also lets the host stand-in retire the buffers it has played.
+        ndspChnIsPlaying(channel);
+        if (finished) return;
+
+        int queued = 0;
+        for (int i = 0; i < MUSIC_BUFFER_COUNT; i++) {
+            if (buffers[i].status == NDSP_WBUF_QUEUED || buffers[i].status == NDSP_WBUF_PLAYING) {
+                queued++;
+            }
+        }
+        if (queued == 0 && primed) {
+            underruns++;
+        }
+        for (int i = 0; i < MUSIC_BUFFER_COUNT; i++) {
+            if (buffers[i].status == NDSP_WBUF_FREE || buffers[i].status == NDSP_WBUF_DONE) {
+                if (!fill(i)) {
+                    finished = true;
+                    return;
+                }
+            }
+        }
+        primed = true;
+    }
+
+    static void threadMain(void* arg) {
+        MusicStream* stream = (MusicStream*)arg;
+        while (stream->running) {
+            stream->service();
+            svcSleepThread(MUSIC_POLL_NS);
+        }
+    }
+
+public:
+    MusicStream(AudioManager& am_, int channel_ = MUSIC_CHANNEL) : am(am_), channel(channel_) {
+        // Sized for the largest layout (16-bit stereo) so start() never allocates.
+        pcm = (u8*)trackedLinearAlloc(MEM_MUSIC, MUSIC_PCM_BYTES);
+        if (!pcm) {
+            printf("Failed to allocate music buffers\n");
+        }
+        memset(buffers, 0, sizeof(buffers));
+    }
+    ~MusicStream() {
+        stop();
+        trackedLinearFree(MEM_MUSIC, pcm, MUSIC_PCM_BYTES);
+    }
+    MusicStream(const MusicStream&) = delete;
+    MusicStream& operator=(const MusicStream&) = delete;
+
+    bool start(const char* path, bool loop_ = true) {
+        stop();
+        if (!am.isInitialized() || !pcm) return false;
+        loop = loop_;
+        if (!openWav(path)) {
+            closeFile();
+            return false;
+        }
+
+        ndspChnWaveBufClear(channel);
+        ndspChnSetInterp(channel, NDSP_INTERP_LINEAR);
+        ndspChnSetRate(channel, sampleRate);
+        ndspChnSetFormat(channel, format);
+        am.setVolume(channel, 1.0f);
+        memset(buffers, 0, sizeof(buffers));
+        finished = false;
+        primed = false;
+
+        // One step above the game thread so the refill is not starved by a
+        // long frame.
+        s32 priority = 0x30;
+        svcGetThreadPriority(&priority, CUR_THREAD_HANDLE);
+        running = true;
+        thread = threadCreate(threadMain, this, MUSIC_THREAD_STACK, priority - 1, -2, false);
+        if (!thread) {
+            printf("Failed to start the music thread\n");
+            running = false;
+            closeFile();
+            return false;
+        }
+        return true;
+    }
+
+    void stop() {
+        if (thread) {
+            running = false;
+            threadJoin(thread, U64_MAX);
+            threadFree(thread);
+            thread = nullptr;
+            ndspChnWaveBufClear(channel);
+        }
+        closeFile();
+    }
+
+    bool isPlaying() {
+        return thread && (!finished || ndspChnIsPlaying(channel));
+    }
+    void setVolume(float volume) {
+        am.setVolume(channel, volume);
+    }
+    u32 underrunCount() const {
+        return underruns;
+    }
+    u32 chunksStreamed() const {
+        return chunks;
+    }
+};
@@ -0,0 +1,179 @@
+#pragma once
+
+#include "main.h"
+
+// The scalar type the physics path (Body2D, so the player) is built with:
+// double, float or Fixed16. Double math is markedly slower than float on the
+// ARM11's VFP, so float is the default; `rocketgame_bench numeric` compares
+// all three. The host build takes -DROCKET_PHYSICS_SCALAR=<type> to try
+// another.
+#ifndef PHYSICS_SCALAR
+#define PHYSICS_SCALAR float
+#endif
+
+// Signed 16.16 fixed point. Products and quotients go through 64 bits, so
+// anything that fits in +-32767 before and after is exact to 1/65536.
+struct Fixed16 {
+    s32 raw = 0;
+
+    Fixed16() {}
+    Fixed16(int value) : raw(value * 65536) {}
+    Fixed16(float value) : raw((s32)(value * 65536.0f)) {}
+    Fixed16(double value) : raw((s32)(value * 65536.0)) {}
+    static Fixed16 fromRaw(s32 raw) {
+        Fixed16 f;
+        f.raw = raw;
+        return f;
+    }
+    float toFloat() const {
+        return raw * (1.0f / 65536.0f);
+    }
+
+    friend Fixed16 operator+(Fixed16 a, Fixed16 b) { return fromRaw(a.raw + b.raw); }
+    friend Fixed16 operator-(Fixed16 a, Fixed16 b) { return fromRaw(a.raw - b.raw); }
+    friend Fixed16 operator*(Fixed16 a, Fixed16 b) { return fromRaw((s32)(((s64)a.raw * b.raw) >> 16)); }
+    friend Fixed16 operator/(Fixed16 a, Fixed16 b) { return fromRaw((s32)(((s64)a.raw << 16) / b.raw)); }
+    Fixed16 operator-() const { return fromRaw(-raw); }
+    Fixed16 & operator+=(Fixed16 b) { raw += b.raw; return *this; }
+    Fixed16 & operator-=(Fixed16 b) { raw -= b.raw; return *this; }
+    Fixed16 & operator*=(Fixed16 b) { return *this = *this * b; }
+    Fixed16 & operator/=(Fixed16 b) { return *this = *this / b; }
+    friend bool operator<(Fixed16 a, Fixed16 b) { return a.raw < b.raw; }
+    friend bool operator>(Fixed16 a, Fixed16 b) { return a.raw > b.raw; }
+    friend bool operator<=(Fixed16 a, Fixed16 b) { return a.raw <= b.raw; }
+    friend bool operator>=(Fixed16 a, Fixed16 b) { return a.raw >= b.raw; }
+    friend bool operator==(Fixed16 a, Fixed16 b) { return a.raw == b.raw; }
+    friend bool operator!=(Fixed16 a, Fixed16 b) { return a.raw != b.raw; }
+};
+
+// Conversions in and out of a numeric policy, for the places that hand
+// values to float-only code (rendering, collision, the HUD).
+template<typename T> struct Numeric {
+    static float toFloat(T value) { return (float)value; }
+    static T abs(T value) { return value < 0 ? -value : value; }
+    static const char* name();
+};
+template<> struct Numeric<Fixed16> {
+    static float toFloat(Fixed16 value) { return value.toFloat(); }
+    static Fixed16 abs(Fixed16 value) { return Fixed16::fromRaw(value.raw < 0 ? -value.raw : value.raw); }
+    static const char* name() { return "fixed16"; }
+};
+template<> inline const char* Numeric<double>::name() { return "double"; }
+template<> inline const char* Numeric<float>::name() { return "float"; }
+
+typedef PHYSICS_SCALAR Scalar;
+
+// Angles are binary: a full turn is 65536, so wrapping is free and the top
+// bits index the tables directly.
+typedef u16 Angle;
+#define ANGLE_QUARTER 16384
+#define ANGLE_HALF 32768
+#define ANGLE_TO_RADIANS (6.28318531f / 65536.0f)
+
+inline Angle radiansToAngle(float radians) {
+    return (Angle)(s64)(radians * (65536.0f / 6.28318531f));
+}
+
+#define TRIG_TABLE_BITS 10
+#define TRIG_TABLE_SIZE (1 << TRIG_TABLE_BITS)
+#define ATAN_TABLE_SIZE 256
+
+// sine over a whole turn, and atan(i / ATAN_TABLE_SIZE) for the first
+// octant, filled in once before main() runs.
+struct TrigTables {
+    float sine[TRIG_TABLE_SIZE];
+    u16 atan[ATAN_TABLE_SIZE + 1];
+    TrigTables() {
+        for (int i = 0; i < TRIG_TABLE_SIZE; i++) {
+            sine[i] = std::sin(i * (6.28318531 / TRIG_TABLE_SIZE));
+        }
+        for (int i = 0; i <= ATAN_TABLE_SIZE; i++) {
+            atan[i] = (u16)(std::atan((double)i / ATAN_TABLE_SIZE) * (65536.0 / 6.28318531) + 0.5);
+        }
+    }
+};
+inline const TrigTables trigTables;
+
+// Nearest table entry, rounding the angle to the closest of the 1024 (the
+// last rounds up to entry 0): within 0.18 degrees, so about 0.003 off.
+inline float lutSin(Angle angle) {
+    return trigTables.sine[((angle + (1 << (15 - TRIG_TABLE_BITS))) >> (16 - TRIG_TABLE_BITS)) & (TRIG_TABLE_SIZE - 1)];
+}
+inline float lutCos(Angle angle) {
+    return lutSin(angle + ANGLE_QUARTER);
+}
+
+// atan2 by octant: the smaller of |x| and |y| over the larger indexes the
+// first-octant table, with linear interpolation between entries; the signs
+// and which one was larger pick the octant. Good to about 0.01 degrees.
+inline Angle lutAtan2(float y, float x) {
+    float ax = x < 0 ? -x : x, ay = y < 0 ? -y : y;
+    if (ax == 0 && ay == 0) return 0;
+    bool steep = ay > ax;
+    float ratio = steep ? ax / ay : ay / ax;
+    float position = ratio * ATAN_TABLE_SIZE;
+    int index = (int)position;
+    if (index >= ATAN_TABLE_SIZE) index = ATAN_TABLE_SIZE - 1;
+    float fraction = position - index;
+    int angle = trigTables.atan[index] + (int)((trigTables.atan[index + 1] - trigTables.atan[index]) * fraction + 0.5f);
+    if (steep) angle = ANGLE_QUARTER - angle;
+    if (x < 0) angle = ANGLE_HALF - angle;
+    if (y < 0) angle = -angle;
+    return (Angle)angle;
+}
+
+// Position and velocity of one moving thing, in the chosen numeric policy.
+template<typename T>
+struct Body2D {
+    T x, y, prevX, prevY;
+    T xVel = 0, yVel = 0;
+
+    Body2D(T x_, T y_) : x(x_), y(y_), prevX(x_), prevY(y_) {}
+
+    void applyForce(T fx, T fy) {
+        xVel += fx;
+        yVel += fy;
+    }
+    void integrate(T dt) {
+        prevX = x;
+        prevY = y;
+        x += xVel * dt;
+        y += yVel * dt;
+    }
+    // Wraps around the edges of a width x height field. After a wrap the
+    // previous position is moved too, so nothing interpolates across it.
+    void wrap(T width, T height) {
+        if (x > width) {
+            x = 0;
+        } else if (x < 0) {
+            x = width;
+        }
+        if (y > height) {
+            y = 0;
+        } else if (y < 0) {
+            y = height;
+        }
+        if (Numeric<T>::abs(x - prevX) > width / 2 || Numeric<T>::abs(y - prevY) > height / 2) {
+            prevX = x;
+            prevY = y;
+        }
+    }
+    // Keeps the body inside a width x height field. It stops dead against
+    // an edge: the velocity into it is dropped.
+    void clamp(T width, T height) {
+        if (x > width) {
+            x = width;
+            xVel = 0;
+        } else if (x < 0) {
+            x = 0;
+            xVel = 0;
+        }
+        if (y > height) {
+            y = height;
+            yVel = 0;
+        } else if (y < 0) {
+            y = 0;
+            yVel = 0;
+        }
+    }
+};
@@ -0,0 +1,62 @@
+// On-disk layout of the packed asset archive (romfs/game.pak). Shared by the
+// game and tools/asset_pack, so it only depends on the C standard types.
+//
+//   PakHeader
+//   PakEntry[count]        sorted by name
+//   asset data             each asset starts on a PAK_ALIGN boundary
+//
+// All integers are little-endian, like both the 3DS and the host.
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define PAK_MAGIC 0x4B415052 // "RPAK" in file byte order
+#define PAK_VERSION 1
+#define PAK_NAME_LENGTH 24
+#define PAK_ALIGN 16
+
+enum PakFormat : uint32_t {
+    PAK_FORMAT_RAW = 0,
+    PAK_FORMAT_T3X = 1,
+    PAK_FORMAT_WAV = 2,
+};
+
+struct PakHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t count;
+    uint32_t reserved;
+};
+
+struct PakEntry {
+    char name[PAK_NAME_LENGTH]; // NUL-padded
+    uint32_t offset;            // from the start of the file
+    uint32_t size;
+    uint32_t format;            // PakFormat
+    uint32_t crc32;
+};
+
+struct PakCrcTable {
+    uint32_t values[256];
+    PakCrcTable() {
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            values[i] = c;
+        }
+    }
+};
+
+// Standard CRC-32 (IEEE 802.3, as used by zip and PNG).
+inline uint32_t pakCrc32(const void* data, size_t size) {
+    static const PakCrcTable table;
+    const uint8_t* bytes = (const uint8_t*)data;
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < size; i++) {
+        crc = table.values[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
@@ -0,0 +1,149 @@
+#pragma once
+
+#include "main.h"
+#include "simd.h"
+#include "snapshot.h"
+#include "random.h"
+#include "numeric.h"
+#include "memory.h"
+
+#define PARTICLE_BUDGET 4096
+// Particles are cosmetic, so they draw from their own stream; gameplay
+// randomness (and with it every recorded replay) is unaffected by them.
+#define PARTICLE_RNG_STREAM 0x5041525449434C45ULL
+
+// What one emission looks like. Each particle gets a random direction within
+// `spread` of `angle` (binary angles, see numeric.h), a speed between speedMin
+// and speedMax, and inherits the emitter's velocity on top.
+struct ParticleBurst {
+    float x, y;
+    float xVel = 0, yVel = 0;
+    Angle angle = 0, spread = ANGLE_HALF;
+    float speedMin = 20, speedMax = 60;
+    float life = 0.5f;
+    u32 color = C2D_Color32(255, 255, 255, 255);
+    float size = 2.0f;
+};
+
+// A fixed pool of up to PARTICLE_BUDGET particles in parallel float arrays,
+// like Asteroids. Emission fills a whole burst at once; update integrates
+// every particle with the packed-array helpers, then removes the expired
+// ones by swapping with the last. When the pool is full, further particles
+// are dropped and counted rather than growing it.
+class Particles {
+    Rng rng;
+    u32 dropped = 0;
+    int peak = 0;
+
+    void remove(int i) {
+        int last = x.size() - 1;
+        x[i] = x[last];
+        y[i] = y[last];
+        prevX[i] = prevX[last];
+        prevY[i] = prevY[last];
+        xVel[i] = xVel[last];
+        yVel[i] = yVel[last];
+        life[i] = life[last];
+        invLife[i] = invLife[last];
+        size[i] = size[last];
+        color[i] = color[last];
+        x.pop_back();
+        y.pop_back();
+        prevX.pop_back();
+        prevY.pop_back();
+        xVel.pop_back();
+        yVel.pop_back();
+        life.pop_back();
+        invLife.pop_back();
+        size.pop_back();
+        color.pop_back();
+    }
+
+    float uniform() {
+        return (rng.next() >> 8) * (1.0f / 16777216.0f);
+    }
+public:
+    std::vector<float> x, y, prevX, prevY, xVel, yVel, life, invLife, size;
+    std::vector<u32> color;
+    // Velocity kept per second, so particles slow down as they fade.
+    float drag = 0.2f;
+
+    explicit Particles(u64 seed) : rng(seed, PARTICLE_RNG_STREAM) {
+        MemoryScope scope(MEM_PARTICLES);
+        x.reserve(PARTICLE_BUDGET);
+        y.reserve(PARTICLE_BUDGET);
+        prevX.reserve(PARTICLE_BUDGET);
+        prevY.reserve(PARTICLE_BUDGET);
+        xVel.reserve(PARTICLE_BUDGET);
+        yVel.reserve(PARTICLE_BUDGET);
+        life.reserve(PARTICLE_BUDGET);
+        invLife.reserve(PARTICLE_BUDGET);
+        size.reserve(PARTICLE_BUDGET);
+        color.reserve(PARTICLE_BUDGET);
+    }
+    int count() const {
+        return x.size();
+    }
+    int peakCount() const {
+        return peak;
+    }
+    u32 droppedCount() const {
+        return dropped;
+    }
+
+    void emit(const ParticleBurst & burst, int n) {
+        int room = PARTICLE_BUDGET - count();
+        if (n > room) {
+            dropped += n - room;
+            n = room;
+        }
+        for (int i = 0; i < n; i++) {
+            Angle angle = burst.angle + rng.below(2 * burst.spread + 1) - burst.spread;
+            float speed = burst.speedMin + uniform() * (burst.speedMax - burst.speedMin);
+            // Stagger lifetimes a little so a burst thins out instead of
+            // vanishing on one step.
+            float lifetime = burst.life * (0.6f + 0.4f * uniform());
+            x.push_back(burst.x);
+            y.push_back(burst.y);
+            prevX.push_back(burst.x);
+            prevY.push_back(burst.y);
+            xVel.push_back(burst.xVel + lutCos(angle) * speed);
+            yVel.push_back(burst.yVel + lutSin(angle) * speed);
+            life.push_back(lifetime);
+            invLife.push_back(1.0f / lifetime);
+            size.push_back(burst.size);
+            color.push_back(burst.color);
+        }
+        if (count() > peak) {
+            peak = count();
+        }
+    }
+
+    void update(float dt) {
+        int n = count();
+        std::copy(x.begin(), x.end(), prevX.begin());
+        std::copy(y.begin(), y.end(), prevY.begin());
+        integrateAxis(x.data(), xVel.data(), n, dt);
+        integrateAxis(y.data(), yVel.data(), n, dt);
+        float damping = 1.0f - (1.0f - drag) * dt;
+        scaleAxis(xVel.data(), n, damping);
+        scaleAxis(yVel.data(), n, damping);
+        float* remaining = life.data();
+        for (int i = 0; i < n; i++) {
+            remaining[i] -= dt;
+        }
+        for (int i = n - 1; i >= 0; i--) {
+            if (life[i] <= 0) {
+                remove(i);
+            }
+        }
+    }
+
+    // Alpha fades out with the remaining life.
+    void snapshotParticles(RenderSnapshot & out) const {
+        for (int i = 0; i < count(); i++) {
+            u32 alpha = (u32)(life[i] * invLife[i] * 255.0f);
+            out.addParticle(prevX[i], prevY[i], x[i], y[i], (color[i] & 0x00FFFFFF) | (alpha << 24), size[i]);
+        }
+    }
+};
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "main.h"
+#include "hud.h"
+#include "particles.h"
+#include "animation.h"
+#include "snapshot.h"
+#include "state_hash.h"
+#include "numeric.h"
+#include "world.h"
+
+class Player {
+    private:
+        const int imageWidth = 32, imageHeight = 53;
+        Body2D<Scalar> body;
+        const float scale = PLAYER_SCALE;
+        // Binary angle the sprite is drawn at.
+        Angle heading = ANGLE_QUARTER;
+        const int width = std::floor((float)32*scale);
+        const int height = std::floor((float)53*scale);
+        bool boosting = true;
+        AnimClip anim = ANIM_ROCKET_BOOST;
+        u32 animStep = 0;
+    public:
+        Fuel fuel{};
+        Health health{};
+        // Asteroids still hit, but do no damage.
+        bool invulnerable = false;
+        // Where booster exhaust goes; none is emitted if this is null.
+        Particles* exhaust = nullptr;
+        Player(double x_, double y_) : body(Scalar(x_), Scalar(y_)) {
+        }
+        void applyForce(float x_, float y_) {
+            body.applyForce(Scalar(x_), Scalar(y_));
+            if (exhaust && (x_ != 0 || y_ != 0)) {
+                emitExhaust(lutAtan2(-y_, -x_), 6, 0.4f);
+            }
+
+        }
+        // Exhaust leaves the tail of the rocket, opposite to the thrust.
+        void emitExhaust(Angle angle, int count, float life) {
+            ParticleBurst burst;
+            burst.x = Numeric<Scalar>::toFloat(body.x) + lutCos(angle) * height * 0.5f;
+            burst.y = Numeric<Scalar>::toFloat(body.y) + lutSin(angle) * height * 0.5f;
+            burst.xVel = Numeric<Scalar>::toFloat(body.xVel);
+            burst.yVel = Numeric<Scalar>::toFloat(body.yVel);
+            burst.angle = angle;
+            burst.spread = ANGLE_HALF / 9;
+            burst.speedMin = 60;
+            burst.speedMax = 120;
+            burst.life = life;
+            burst.color = C2D_Color32(255, 160, 40, 255);
+            exhaust->emit(burst, count);
+        }
+        void setHeading(Angle heading_) {
+            heading = heading_;
+        }
+
+        void update(double dt) {
+            body.integrate(Scalar(dt));
+            animStep = animations().advance(anim, animStep);
+
+        }
+        std::pair<float, float> getPosition() const {
+            return std::pair<float, float>(Numeric<Scalar>::toFloat(body.x), Numeric<Scalar>::toFloat(body.y));
+        }
+        // Position at the start of the last step, for interpolation.
+        std::pair<float, float> getPreviousPosition() const {
+            return std::pair<float, float>(Numeric<Scalar>::toFloat(body.prevX), Numeric<Scalar>::toFloat(body.prevY));
+        }
+        Angle getHeading() const {
+            return heading;
+        }
+        void hashState(StateHash & hash) const {
+            hash.add(body.x);
+            hash.add(body.y);
+            hash.add(body.xVel);
+            hash.add(body.yVel);
+            hash.add(heading);
+            hash.add(boosting);
+            hash.add(fuel.level());
+            hash.add(health.level());
+        }
+        void snapshot(RenderSnapshot & out) const {
+            const AnimFrame & frame = animations().frameAt(anim, animStep);
+            out.add(frame.image, LAYER_PLAYER, Numeric<Scalar>::toFloat(body.prevX), Numeric<Scalar>::toFloat(body.prevY),
+                    Numeric<Scalar>::toFloat(body.x), Numeric<Scalar>::toFloat(body.y), heading * ANGLE_TO_RADIANS, scale,
+                    frame.pivotX, frame.pivotY);
+        }
+        // Lighting the booster gives one bigger puff along the current heading.
+        void booster(bool on) {
+            if (exhaust && on && !boosting) {
+                emitExhaust(heading + ANGLE_QUARTER, 24, 0.6f);
+            }
+            if (on != boosting) {
+                anim = on ? ANIM_ROCKET_BOOST : ANIM_ROCKET_IDLE;
+                animStep = 0;
+            }
+            boosting = on;
+        }
+        // The world has hard edges; the rocket stops against them.
+        void checkBounds() {
+            body.clamp(Scalar(WORLD_WIDTH), Scalar(WORLD_HEIGHT));
+        }
+
+};
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "main.h"
+
+// Refers to an entity stored in a dense, swap-and-pop array. The handle stays
+// valid while the entity lives even as other entities are moved around to
+// fill holes, and goes stale (indexOf returns -1) once it is removed.
+struct EntityHandle {
+    u32 slot = 0xFFFFFFFF;
+    u32 generation = 0;
+};
+
+// Fixed-capacity mapping between handle slots and dense indices. All storage
+// is allocated in the constructor; add/remove only pop and push the free list.
+class HandleTable {
+    std::vector<u32> slotToDense;
+    std::vector<u32> denseToSlot;
+    std::vector<u32> generations;
+    std::vector<u32> freeSlots;
+public:
+    explicit HandleTable(int capacity) : slotToDense(capacity), denseToSlot(capacity), generations(capacity, 0) {
+        freeSlots.reserve(capacity);
+        for (int slot = capacity - 1; slot >= 0; slot--) {
+            freeSlots.push_back(slot);
+        }
+    }
+
+    bool full() const {
+        return freeSlots.empty();
+    }
+
+    // Registers the entity that was just appended at denseIndex.
+    EntityHandle add(int denseIndex) {
+        u32 slot = freeSlots.back();
+        freeSlots.pop_back();
+        slotToDense[slot] = denseIndex;
+        denseToSlot[denseIndex] = slot;
+        return EntityHandle{slot, generations[slot]};
+    }
+
+    // Mirrors a swap-and-pop: the entity at denseIndex dies and the one at
+    // lastIndex moves into its place.
+    void removeSwap(int denseIndex, int lastIndex) {
+        u32 slot = denseToSlot[denseIndex];
+        generations[slot]++;
+        freeSlots.push_back(slot);
+        u32 movedSlot = denseToSlot[lastIndex];
+        denseToSlot[denseIndex] = movedSlot;
+        slotToDense[movedSlot] = denseIndex;
+    }
+
+    int indexOf(EntityHandle handle) const {
+        if (handle.slot >= generations.size() || generations[handle.slot] != handle.generation) {
+            return -1;
+        }
+        return slotToDense[handle.slot];
+    }
+
+    EntityHandle handleAt(int denseIndex) const {
+        u32 slot = denseToSlot[denseIndex];
+        return EntityHandle{slot, generations[slot]};
+    }
+};
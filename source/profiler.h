@@ -0,0 +1,185 @@
+#pragma once
+
+#include "main.h"
+#include "frame_arena.h"
+#include <atomic>
+
+#define PROFILER_HISTORY 256
+#define PROFILER_GRAPH_FRAMES 64
+#define FRAME_BUDGET_MS (1000.0f / 60.0f)
+#define STEP_BUDGET_MS (1000.0f / SIM_HZ)
+
+enum ProfilePhase {
+    PHASE_INPUT,
+    PHASE_UPDATE,
+    PHASE_COLLIDE,
+    PHASE_EXPLOSIONS,
+    PHASE_DRAW_TOP,
+    PHASE_DRAW_BOTTOM,
+    PHASE_FRAME_END,
+    PHASE_COUNT
+};
+
+inline const char* profilePhaseName(int phase) {
+    static const char* names[PHASE_COUNT] = {
+        "input", "update", "collide", "explosions", "draw_top", "draw_bottom", "frame_end"
+    };
+    return names[phase];
+}
+
+struct ProfileFrame {
+    u32 ticks[PHASE_COUNT];
+};
+
+// Keeps per-phase system tick totals for the last PROFILER_HISTORY frames.
+// Any thread may add() time to a phase; the totals are atomics, so work on
+// the simulation thread lands in whichever render frame it finished in. The
+// main loop is the only caller of endFrame(): it drains the totals into the
+// ring and publishes the frame by bumping `written` with release ordering,
+// so readers on any thread can take a snapshot without a lock. A reader only
+// sees torn data if it stalls for a whole ring's worth of frames.
+class FrameProfiler {
+    ProfileFrame ring[PROFILER_HISTORY];
+    std::atomic<u32> current[PHASE_COUNT];
+    std::atomic<u32> written{0};
+    u64 lastEndTick = 0;
+    u32 lastInterval = 0;
+public:
+    // Hidden until SELECT: while shown it redraws the bottom screen every
+    // frame.
+    bool overlayVisible = false;
+
+    FrameProfiler() {
+        memset(ring, 0, sizeof(ring));
+        for (int phase = 0; phase < PHASE_COUNT; phase++) {
+            current[phase].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    void add(ProfilePhase phase, u64 ticks) {
+        current[phase].fetch_add(ticks, std::memory_order_relaxed);
+    }
+    void endFrame() {
+        u64 now = svcGetSystemTick();
+        lastInterval = lastEndTick ? now - lastEndTick : 0;
+        lastEndTick = now;
+        u32 index = written.load(std::memory_order_relaxed);
+        ProfileFrame & frame = ring[index % PROFILER_HISTORY];
+        for (int phase = 0; phase < PHASE_COUNT; phase++) {
+            frame.ticks[phase] = current[phase].exchange(0, std::memory_order_relaxed);
+        }
+        written.store(index + 1, std::memory_order_release);
+    }
+
+    // Copies up to `count` of the most recent frames, oldest first.
+    int snapshot(ProfileFrame* out, int count) const {
+        u32 end = written.load(std::memory_order_acquire);
+        int available = end < PROFILER_HISTORY ? end : PROFILER_HISTORY;
+        if (count > available) count = available;
+        for (int i = 0; i < count; i++) {
+            out[i] = ring[(end - count + i) % PROFILER_HISTORY];
+        }
+        return count;
+    }
+
+    // Time between the last two endFrame() calls, waiting for vblank
+    // included: how long the render thread really took to show a frame. The
+    // phase totals can't give this, since they mix in simulation work that
+    // ran alongside on another thread. Only for the thread calling endFrame().
+    float lastFrameIntervalMs() const {
+        return ticksToMs(lastInterval);
+    }
+
+    static float ticksToMs(u64 ticks) {
+        return ticks / (SYSCLOCK_ARM11 / 1000.0f);
+    }
+
+    // Stacked bar per frame, one colour per phase, scaled so the full
+    // height is two frame budgets. The white line marks 16.6 ms.
+    void drawOverlay(float x, float y, float width, float height) const {
+        if (!overlayVisible) return;
+        static const u32 colors[PHASE_COUNT] = {
+            C2D_Color32(120, 120, 120, 255),
+            C2D_Color32(60, 140, 255, 255),
+            C2D_Color32(255, 80, 80, 255),
+            C2D_Color32(255, 180, 40, 255),
+            C2D_Color32(80, 220, 120, 255),
+            C2D_Color32(40, 160, 80, 255),
+            C2D_Color32(200, 80, 220, 255),
+        };
+        ProfileFrame* frames = frameArena().allocArray<ProfileFrame>(PROFILER_GRAPH_FRAMES);
+        if (!frames) return;
+        int count = snapshot(frames, PROFILER_GRAPH_FRAMES);
+        float barWidth = width / PROFILER_GRAPH_FRAMES;
+        float pixelsPerMs = height / (2 * FRAME_BUDGET_MS);
+        float bottom = y + height;
+
+        C2D_DrawRectSolid(x, y, 0.5f, width, height, C2D_Color32(20, 20, 30, 255));
+        for (int i = 0; i < count; i++) {
+            float top = bottom;
+            for (int phase = 0; phase < PHASE_COUNT; phase++) {
+                float h = ticksToMs(frames[i].ticks[phase]) * pixelsPerMs;
+                if (h <= 0) continue;
+                if (top - h < y) h = top - y;
+                top -= h;
+                C2D_DrawRectSolid(x + i * barWidth, top, 0.6f, barWidth, h, colors[phase]);
+            }
+        }
+        C2D_DrawRectSolid(x, bottom - FRAME_BUDGET_MS * pixelsPerMs, 0.7f, width, 1, C2D_Color32(255, 255, 255, 255));
+    }
+
+    // One row per frame, oldest first, times in milliseconds.
+    void dumpCsv(FILE* out) const {
+        ProfileFrame* frames = frameArena().allocArray<ProfileFrame>(PROFILER_HISTORY);
+        if (!frames) return;
+        int count = snapshot(frames, PROFILER_HISTORY);
+        fprintf(out, "frame");
+        for (int phase = 0; phase < PHASE_COUNT; phase++) {
+            fprintf(out, ",%s_ms", profilePhaseName(phase));
+        }
+        fprintf(out, ",total_ms\n");
+        for (int i = 0; i < count; i++) {
+            float total = 0;
+            fprintf(out, "%d", i);
+            for (int phase = 0; phase < PHASE_COUNT; phase++) {
+                float ms = ticksToMs(frames[i].ticks[phase]);
+                total += ms;
+                fprintf(out, ",%.3f", ms);
+            }
+            fprintf(out, ",%.3f\n", total);
+        }
+    }
+    bool dumpCsv(const char* path) const {
+        FILE* file = fopen(path, "w");
+        if (!file) {
+            printf("Failed to open %s\n", path);
+            return false;
+        }
+        dumpCsv(file);
+        fclose(file);
+        return true;
+    }
+};
+
+inline FrameProfiler & frameProfiler() {
+    static FrameProfiler profiler;
+    return profiler;
+}
+
+class ProfileScope {
+    ProfilePhase phase;
+    u64 start;
+public:
+    ProfileScope(ProfilePhase phase_) : phase(phase_), start(svcGetSystemTick()) {}
+    ~ProfileScope() {
+        frameProfiler().add(phase, svcGetSystemTick() - start);
+    }
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#if PROFILE
+#define PROFILE_SCOPE(phase) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(phase)
+#else
+#define PROFILE_SCOPE(phase) do {} while (0)
+#endif
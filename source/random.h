@@ -0,0 +1,36 @@
+#pragma once
+
+#include "main.h"
+
+// PCG32 (O'Neill, XSH-RR variant). Small, fast on ARM11 and, unlike rand(),
+// owned by whoever needs it, so a run is reproducible from its seed alone.
+class Rng {
+    u64 state = 0;
+    u64 increment;
+public:
+    explicit Rng(u64 seed, u64 stream = 0xDA3E39CB94B95BDBULL) : increment((stream << 1) | 1) {
+        next();
+        state += seed;
+        next();
+    }
+
+    u32 next() {
+        u64 old = state;
+        state = old * 6364136223846793005ULL + increment;
+        u32 xorshifted = (u32)(((old >> 18) ^ old) >> 27);
+        u32 rot = (u32)(old >> 59);
+        return (xorshifted >> rot) | (xorshifted << ((-rot) & 31));
+    }
+    // Uniform integer in [0, n). Uses a multiply instead of %, which is
+    // both unbiased enough for gameplay and cheaper than a divide.
+    int below(int n) {
+        return (int)(((u64)next() * (u32)n) >> 32);
+    }
+    // Uniform integer in [lo, hi).
+    int between(int lo, int hi) {
+        return lo + below(hi - lo);
+    }
+    u64 getState() const {
+        return state;
+    }
+};
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "main.h"
+#include "state_hash.h"
+
+// Where sorted draws end up. SpriteBatch and SnapshotRenderer only decide
+// what to draw and in which order; a backend submits it. Citro2dBackend
+// draws to the current citro2d scene. HeadlessBackend draws nothing and
+// just counts and checksums the commands, so rendering can be timed apart
+// from submission and compared between builds on the host.
+class RenderBackend {
+public:
+    virtual ~RenderBackend() {}
+    virtual void drawImage(const C2D_Image & image, const C2D_DrawParams & params) = 0;
+    virtual void drawRect(float x, float y, float w, float h, u32 color) = 0;
+};
+
+class Citro2dBackend : public RenderBackend {
+public:
+    void drawImage(const C2D_Image & image, const C2D_DrawParams & params) override {
+        C2D_DrawImage(image, &params, NULL);
+    }
+    void drawRect(float x, float y, float w, float h, u32 color) override {
+        C2D_DrawRectSolid(x, y, 0.5f, w, h, color);
+    }
+};
+
+// The checksum covers each command's image (by its place in the texture,
+// not its address) and its exact parameters, in submission order.
+class HeadlessBackend : public RenderBackend {
+    StateHash hash;
+    u64 images = 0, rects = 0;
+public:
+    void drawImage(const C2D_Image & image, const C2D_DrawParams & params) override {
+        images++;
+        hash.add(image.subtex->left);
+        hash.add(image.subtex->top);
+        hash.add(image.subtex->right);
+        hash.add(image.subtex->bottom);
+        hash.add(params.pos);
+        hash.add(params.center);
+        hash.add(params.depth);
+        hash.add(params.angle);
+    }
+    void drawRect(float x, float y, float w, float h, u32 color) override {
+        rects++;
+        hash.add(x);
+        hash.add(y);
+        hash.add(w);
+        hash.add(h);
+        hash.add(color);
+    }
+    u64 imageCount() const {
+        return images;
+    }
+    u64 rectCount() const {
+        return rects;
+    }
+    u64 checksum() const {
+        return hash.get();
+    }
+};
@@ -0,0 +1,196 @@
+#pragma once
+
+#include "main.h"
+#include "game.h"
+#include "memory.h"
+
+#define REPLAY_MAGIC 0x50524B52 // "RKRP" in file byte order
+// Raised whenever the simulation or Game::hashState() changes, so older
+// recordings are rejected on load instead of ending in a mismatch.
+#define REPLAY_VERSION 8
+#define REPLAY_MAX_BYTES (256 * 1024)
+#define REPLAY_PLAY_PATH "sdmc:/rocketgame_replay.rpl"
+#define REPLAY_RECORD_PATH "sdmc:/rocketgame_last.rpl"
+
+// A replay is a fixed header followed by one record per simulation step:
+//   u8 flags, then only the fields the flags say changed or are non-zero
+//     REPLAY_HELD   u32 kHeld
+//     REPLAY_STICK  s16 dx, s16 dy
+//     REPLAY_DOWN   u32 kDown
+//     REPLAY_UP     u32 kUp
+// A step where nothing changed costs one byte, so an hour of play at 60
+// steps a second is about 210 KB.
+enum ReplayFlags : u8 {
+    REPLAY_HELD = 1 << 0,
+    REPLAY_STICK = 1 << 1,
+    REPLAY_DOWN = 1 << 2,
+    REPLAY_UP = 1 << 3,
+};
+
+struct ReplayHeader {
+    u32 magic = REPLAY_MAGIC;
+    u32 version = REPLAY_VERSION;
+    u64 seed = 0;
+    u32 asteroidLimit = 0;
+    u32 steps = 0;
+    // Game::hashState() after the last step, for checking a replay.
+    u64 finalHash = 0;
+};
+
+// Logs the input each simulation step consumed. Records go into a buffer
+// reserved up front, so recording never allocates or touches the file system
+// from the simulation thread; save() writes it out after the run. If the
+// buffer fills up, recording stops and the replay is marked truncated.
+class InputRecorder {
+    ReplayHeader header;
+    std::vector<u8> data;
+    InputFrame last;
+    bool truncated = false;
+
+    void put16(u16 value) {
+        data.push_back(value & 0xFF);
+        data.push_back(value >> 8);
+    }
+    void put32(u32 value) {
+        put16(value & 0xFFFF);
+        put16(value >> 16);
+    }
+public:
+    InputRecorder(u64 seed, int asteroidLimit) {
+        header.seed = seed;
+        header.asteroidLimit = asteroidLimit;
+        MemoryScope scope(MEM_REPLAY);
+        data.reserve(REPLAY_MAX_BYTES);
+    }
+
+    void record(const InputFrame & input) {
+        if (truncated) return;
+        if (data.size() + 17 > data.capacity()) {
+            truncated = true;
+            return;
+        }
+        u8 flags = 0;
+        if (input.kHeld != last.kHeld) flags |= REPLAY_HELD;
+        if (input.dx != last.dx || input.dy != last.dy) flags |= REPLAY_STICK;
+        if (input.kDown) flags |= REPLAY_DOWN;
+        if (input.kUp) flags |= REPLAY_UP;
+        data.push_back(flags);
+        if (flags & REPLAY_HELD) put32(input.kHeld);
+        if (flags & REPLAY_STICK) {
+            put16(input.dx);
+            put16(input.dy);
+        }
+        if (flags & REPLAY_DOWN) put32(input.kDown);
+        if (flags & REPLAY_UP) put32(input.kUp);
+        last = input;
+        header.steps++;
+    }
+
+    bool isTruncated() const {
+        return truncated;
+    }
+    u32 steps() const {
+        return header.steps;
+    }
+
+    // A truncated recording is still saved, but without a final hash, since
+    // the game kept running past the last recorded step.
+    bool save(const char* path, u64 finalHash) {
+        header.finalHash = truncated ? 0 : finalHash;
+        FILE* file = fopen(path, "wb");
+        if (!file) {
+            printf("Failed to open %s\n", path);
+            return false;
+        }
+        bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                  fwrite(data.data(), 1, data.size(), file) == data.size();
+        fclose(file);
+        return ok;
+    }
+};
+
+// Feeds a recorded session back in, one InputFrame per simulation step.
+class InputReplay {
+    ReplayHeader header;
+    std::vector<u8> data;
+    size_t cursor = 0;
+    u32 played = 0;
+    InputFrame last;
+
+    u16 get16() {
+        u16 value = data[cursor] | (data[cursor + 1] << 8);
+        cursor += 2;
+        return value;
+    }
+    u32 get32() {
+        u32 low = get16();
+        return low | ((u32)get16() << 16);
+    }
+public:
+    bool load(const char* path) {
+        MemoryScope scope(MEM_REPLAY);
+        FILE* file = fopen(path, "rb");
+        if (!file) {
+            printf("Failed to open %s\n", path);
+            return false;
+        }
+        bool ok = fread(&header, sizeof(header), 1, file) == 1;
+        if (ok && (header.magic != REPLAY_MAGIC || header.version != REPLAY_VERSION)) {
+            printf("%s is not a version %d replay\n", path, REPLAY_VERSION);
+            ok = false;
+        }
+        if (ok) {
+            u8 buf[4096];
+            size_t n;
+            while ((n = fread(buf, 1, sizeof(buf), file)) > 0) {
+                data.insert(data.end(), buf, buf + n);
+            }
+        }
+        fclose(file);
+        cursor = 0;
+        played = 0;
+        last = InputFrame();
+        return ok;
+    }
+
+    // Fills in the next step's input; false once the recording is exhausted.
+    bool next(InputFrame & input) {
+        if (played >= header.steps || cursor >= data.size()) return false;
+        u8 flags = data[cursor++];
+        int need = ((flags & REPLAY_HELD) ? 4 : 0) + ((flags & REPLAY_STICK) ? 4 : 0) +
+                   ((flags & REPLAY_DOWN) ? 4 : 0) + ((flags & REPLAY_UP) ? 4 : 0);
+        if (cursor + need > data.size()) return false;
+        input = last;
+        input.kDown = 0;
+        input.kUp = 0;
+        if (flags & REPLAY_HELD) input.kHeld = get32();
+        if (flags & REPLAY_STICK) {
+            input.dx = (s16)get16();
+            input.dy = (s16)get16();
+        }
+        if (flags & REPLAY_DOWN) input.kDown = get32();
+        if (flags & REPLAY_UP) input.kUp = get32();
+        last = input;
+        played++;
+        return true;
+    }
+
+    bool finished() const {
+        return played >= header.steps;
+    }
+    u32 playedSteps() const {
+        return played;
+    }
+    u64 seed() const {
+        return header.seed;
+    }
+    int asteroidLimit() const {
+        return header.asteroidLimit;
+    }
+    u32 steps() const {
+        return header.steps;
+    }
+    u64 expectedHash() const {
+        return header.finalHash;
+    }
+};
@@ -0,0 +1,153 @@
+#pragma once
+
+#include "main.h"
+#include "game.h"
+#include "timer.h"
+#include "snapshot.h"
+#include "triple_buffer.h"
+#include "replay.h"
+
+#include <atomic>
+
+#define SIM_THREAD_STACK (32 * 1024)
+
+// Input handed from the render thread to the simulation thread. Edge bits
+// are OR-ed in and taken out atomically, so a press is delivered to exactly
+// one step no matter how the two threads' frames line up.
+class InputMailbox {
+    std::atomic<u32> down{0}, up{0}, held{0};
+    std::atomic<u32> stick{0};
+public:
+    void post(u32 kDown, u32 kHeld, u32 kUp, s16 dx, s16 dy) {
+        down.fetch_or(kDown, std::memory_order_relaxed);
+        up.fetch_or(kUp, std::memory_order_relaxed);
+        held.store(kHeld, std::memory_order_relaxed);
+        stick.store((u16)dx | ((u32)(u16)dy << 16), std::memory_order_relaxed);
+    }
+    void take(InputFrame & input) {
+        input.kDown = down.exchange(0, std::memory_order_relaxed);
+        input.kUp = up.exchange(0, std::memory_order_relaxed);
+        input.kHeld = held.load(std::memory_order_relaxed);
+        u32 packed = stick.load(std::memory_order_relaxed);
+        input.dx = (s16)(packed & 0xFFFF);
+        input.dy = (s16)(packed >> 16);
+    }
+};
+
+// Runs Game::step on its own thread at the fixed rate and publishes a render
+// snapshot after every step. Once started, the game and its audio voices
+// belong to this thread; the render thread only posts input and reads
+// snapshots. With a replay attached, input comes from the replay instead of
+// the mailbox and the snapshot reports the game over when it runs out; with
+// a recorder attached, every step's input is logged.
+//
+// On a New 3DS the thread goes to core 2, which is otherwise idle. Elsewhere
+// it shares the main core and relies on sleeping between steps.
+class SimulationThread {
+    Game & game;
+    InputMailbox & input;
+    TripleBuffer<RenderSnapshot> & snapshots;
+    InputRecorder* recorder = nullptr;
+    InputReplay* replay = nullptr;
+    Thread thread = nullptr;
+    std::atomic<bool> running{false};
+
+    void publish(const FixedTimestep & clock, u64 step, u64 stepCost) {
+        RenderSnapshot & out = snapshots.writeBuffer();
+        game.snapshot(out);
+        if (replay && replay->finished()) {
+            out.over = true;
+        }
+        out.step = step;
+        out.tick = svcGetSystemTick();
+        out.stepTicks = clock.ticksPerStep();
+        out.stepCostTicks = stepCost;
+        snapshots.publish();
+    }
+
+    void run() {
+        FixedTimestep clock;
+        InputFrame frame;
+        u64 step = 0;
+        publish(clock, step, 0);
+        while (running) {
+            int steps = clock.advance();
+            u64 worstStep = 0;
+            for (int i = 0; i < steps && !game.over(); i++) {
+                if (replay) {
+                    if (!replay->next(frame)) break;
+                } else {
+                    input.take(frame);
+                }
+                if (recorder) {
+                    recorder->record(frame);
+                }
+                u64 start = svcGetSystemTick();
+                game.step(frame, clock.stepSeconds());
+                worstStep = std::max(worstStep, svcGetSystemTick() - start);
+                step++;
+            }
+            if (steps > 0) {
+                publish(clock, step, worstStep);
+            }
+            svcSleepThread(clock.ticksUntilNextStep() * 1000000000ULL / SYSCLOCK_ARM11);
+        }
+    }
+
+    static void threadMain(void* arg) {
+        ((SimulationThread*)arg)->run();
+    }
+
+public:
+    SimulationThread(Game & game_, InputMailbox & input_, TripleBuffer<RenderSnapshot> & snapshots_)
+        : game(game_), input(input_), snapshots(snapshots_) {
+        MemoryScope scope(MEM_RENDER);
+        for (int i = 0; i < 3; i++) {
+            snapshots.slot(i).reserve(game.spriteCapacity(), PARTICLE_BUDGET);
+        }
+    }
+    ~SimulationThread() {
+        stop();
+    }
+    SimulationThread(const SimulationThread&) = delete;
+    SimulationThread& operator=(const SimulationThread&) = delete;
+
+    // Both must be set before start().
+    void setRecorder(InputRecorder* recorder_) {
+        recorder = recorder_;
+    }
+    void setReplay(InputReplay* replay_) {
+        replay = replay_;
+    }
+
+    bool start() {
+        s32 priority = 0x30;
+        svcGetThreadPriority(&priority, CUR_THREAD_HANDLE);
+        int core = -2;
+        bool isNew3ds = false;
+        APT_CheckNew3DS(&isNew3ds);
+        if (isNew3ds) {
+            core = 2;
+        }
+        running = true;
+        thread = threadCreate(threadMain, this, SIM_THREAD_STACK, priority - 1, core, false);
+        if (!thread && core != -2) {
+            thread = threadCreate(threadMain, this, SIM_THREAD_STACK, priority - 1, -2, false);
+        }
+        if (!thread) {
+            printf("Failed to start the simulation thread\n");
+            running = false;
+            return false;
+        }
+        return true;
+    }
+
+    void stop() {
+        if (thread) {
+            running = false;
+            threadJoin(thread, U64_MAX);
+            threadFree(thread);
+            thread = nullptr;
+        }
+    }
+};
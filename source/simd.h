@@ -0,0 +1,149 @@
+#pragma once
+
+#include "main.h"
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_FEATURE_SIMD32)
+#include <arm_acle.h>
+#endif
+
+// pos[i] += vel[i] * dt over packed float arrays.
+// The 3DS's ARM11 has no NEON, so on device this is the plain loop below
+// (which GCC keeps in VFP registers); the vector paths are for ARMv7+/x86
+// hosts running the benchmarks.
+inline void integrateAxis(float* __restrict pos, const float* __restrict vel, int count, float dt) {
+    int i = 0;
+#if defined(__ARM_NEON)
+    float32x4_t step = vdupq_n_f32(dt);
+    for (; i + 4 <= count; i += 4) {
+        vst1q_f32(pos + i, vmlaq_f32(vld1q_f32(pos + i), vld1q_f32(vel + i), step));
+    }
+#elif defined(__SSE2__)
+    __m128 step = _mm_set1_ps(dt);
+    for (; i + 4 <= count; i += 4) {
+        __m128 p = _mm_loadu_ps(pos + i);
+        __m128 v = _mm_loadu_ps(vel + i);
+        _mm_storeu_ps(pos + i, _mm_add_ps(p, _mm_mul_ps(v, step)));
+    }
+#endif
+    for (; i < count; i++) {
+        pos[i] += vel[i] * dt;
+    }
+}
+
+// v[i] *= factor over a packed float array.
+inline void scaleAxis(float* __restrict v, int count, float factor) {
+    int i = 0;
+#if defined(__ARM_NEON)
+    float32x4_t k = vdupq_n_f32(factor);
+    for (; i + 4 <= count; i += 4) {
+        vst1q_f32(v + i, vmulq_f32(vld1q_f32(v + i), k));
+    }
+#elif defined(__SSE2__)
+    __m128 k = _mm_set1_ps(factor);
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_ps(v + i, _mm_mul_ps(_mm_loadu_ps(v + i), k));
+    }
+#endif
+    for (; i < count; i++) {
+        v[i] *= factor;
+    }
+}
+
+// Audio mixing over interleaved stereo PCM16, with Q15 gains (32767 is just
+// under 1.0): out += (in * gain) >> 15, saturating at the 16-bit limits.
+// Every path rounds the same way, so they agree bit for bit with the scalar
+// loops below. On device this uses the ARM11's own SIMD32 saturating adds
+// (QADD16, both channels of a frame at once); NEON and SSE2 are for hosts.
+inline s16 mixSample(s16 out, s16 in, s16 gain) {
+    s32 sum = out + ((in * gain) >> 15);
+    return sum > 32767 ? 32767 : sum < -32768 ? -32768 : sum;
+}
+
+inline void mixStereoPcm16Scalar(s16* __restrict out, const s16* __restrict in, int frames, s16 gainL, s16 gainR) {
+    for (int i = 0; i < frames; i++) {
+        out[2 * i] = mixSample(out[2 * i], in[2 * i], gainL);
+        out[2 * i + 1] = mixSample(out[2 * i + 1], in[2 * i + 1], gainR);
+    }
+}
+
+// A mono source mixed into both channels.
+inline void mixMonoPcm16Scalar(s16* __restrict out, const s16* __restrict in, int frames, s16 gainL, s16 gainR) {
+    for (int i = 0; i < frames; i++) {
+        out[2 * i] = mixSample(out[2 * i], in[i], gainL);
+        out[2 * i + 1] = mixSample(out[2 * i + 1], in[i], gainR);
+    }
+}
+
+#if defined(__SSE2__) && !defined(__ARM_NEON)
+// (a * b) >> 15 per lane: bits 15..30 of the 32-bit products.
+inline __m128i mulQ15(__m128i a, __m128i b) {
+    return _mm_or_si128(_mm_slli_epi16(_mm_mulhi_epi16(a, b), 1), _mm_srli_epi16(_mm_mullo_epi16(a, b), 15));
+}
+#endif
+
+#if !defined(__ARM_NEON) && !defined(__SSE2__) && defined(__ARM_FEATURE_SIMD32)
+// One stereo frame scaled and added to another with a single QADD16.
+inline void mixFrameSimd32(s16* out, s16 left, s16 right, s16 gainL, s16 gainR) {
+    u32 scaled = (u16)((left * gainL) >> 15) | ((u32)(u16)((right * gainR) >> 15) << 16);
+    u32 acc;
+    memcpy(&acc, out, 4);
+    acc = __qadd16(acc, scaled);
+    memcpy(out, &acc, 4);
+}
+#endif
+
+inline void mixStereoPcm16(s16* __restrict out, const s16* __restrict in, int frames, s16 gainL, s16 gainR) {
+    int i = 0;
+#if defined(__ARM_NEON)
+    int16x4x2_t pair = vzip_s16(vdup_n_s16(gainL), vdup_n_s16(gainR));
+    int16x8_t gain = vcombine_s16(pair.val[0], pair.val[0]);
+    for (; i + 4 <= frames; i += 4) {
+        int16x8_t scaled = vqdmulhq_s16(vld1q_s16(in + 2 * i), gain);
+        vst1q_s16(out + 2 * i, vqaddq_s16(vld1q_s16(out + 2 * i), scaled));
+    }
+#elif defined(__SSE2__)
+    __m128i gain = _mm_set_epi16(gainR, gainL, gainR, gainL, gainR, gainL, gainR, gainL);
+    for (; i + 4 <= frames; i += 4) {
+        __m128i scaled = mulQ15(_mm_loadu_si128((const __m128i*)(in + 2 * i)), gain);
+        __m128i acc = _mm_loadu_si128((const __m128i*)(out + 2 * i));
+        _mm_storeu_si128((__m128i*)(out + 2 * i), _mm_adds_epi16(acc, scaled));
+    }
+#elif defined(__ARM_FEATURE_SIMD32)
+    for (; i < frames; i++) {
+        mixFrameSimd32(out + 2 * i, in[2 * i], in[2 * i + 1], gainL, gainR);
+    }
+#endif
+    mixStereoPcm16Scalar(out + 2 * i, in + 2 * i, frames - i, gainL, gainR);
+}
+
+inline void mixMonoPcm16(s16* __restrict out, const s16* __restrict in, int frames, s16 gainL, s16 gainR) {
+    int i = 0;
+#if defined(__ARM_NEON)
+    int16x4_t left = vdup_n_s16(gainL), right = vdup_n_s16(gainR);
+    for (; i + 4 <= frames; i += 4) {
+        int16x4_t mono = vld1_s16(in + i);
+        int16x4x2_t pairs = vzip_s16(vqdmulh_s16(mono, left), vqdmulh_s16(mono, right));
+        int16x8_t scaled = vcombine_s16(pairs.val[0], pairs.val[1]);
+        vst1q_s16(out + 2 * i, vqaddq_s16(vld1q_s16(out + 2 * i), scaled));
+    }
+#elif defined(__SSE2__)
+    __m128i gain = _mm_set_epi16(gainR, gainL, gainR, gainL, gainR, gainL, gainR, gainL);
+    for (; i + 8 <= frames; i += 8) {
+        __m128i mono = _mm_loadu_si128((const __m128i*)(in + i));
+        __m128i low = mulQ15(_mm_unpacklo_epi16(mono, mono), gain);
+        __m128i high = mulQ15(_mm_unpackhi_epi16(mono, mono), gain);
+        __m128i* dst = (__m128i*)(out + 2 * i);
+        _mm_storeu_si128(dst, _mm_adds_epi16(_mm_loadu_si128(dst), low));
+        _mm_storeu_si128(dst + 1, _mm_adds_epi16(_mm_loadu_si128(dst + 1), high));
+    }
+#elif defined(__ARM_FEATURE_SIMD32)
+    for (; i < frames; i++) {
+        mixFrameSimd32(out + 2 * i, in[i], in[i], gainL, gainR);
+    }
+#endif
+    mixMonoPcm16Scalar(out + 2 * i, in + i, frames - i, gainL, gainR);
+}
@@ -0,0 +1,170 @@
+#pragma once
+
+#include "main.h"
+#include "batch.h"
+#include "atlas_index.h"
+
+// One sprite as the simulation left it: the atlas image to draw and its
+// position at the previous and latest step, so the renderer can interpolate.
+// Rotation is in radians; the pivot is the fraction of the image drawn at
+// (x, y).
+struct SpriteInstance {
+    u16 image;
+    u8 layer;
+    float prevX, prevY, x, y;
+    float rotation;
+    float scale;
+    float pivotX, pivotY;
+};
+
+// One particle: previous and latest position, colour with its current fade
+// already in the alpha, and edge length in pixels.
+struct ParticleInstance {
+    float prevX, prevY, x, y;
+    u32 color;
+    float size;
+};
+
+struct HudState {
+    float fuel = 100.0f;
+    u32 fuelColor = 0;
+    float health = 100.0f;
+    // Whole seconds survived.
+    u32 seconds = 0;
+    int wave = 0;
+};
+
+// Everything the renderer needs from one simulation step. The simulation
+// fills one in place and hands it over whole; after that it is read-only.
+struct RenderSnapshot {
+    std::vector<SpriteInstance> sprites;
+    std::vector<ParticleInstance> particles;
+    HudState hud;
+    bool over = false;
+    u64 step = 0;
+    // System tick at which this step became the latest state.
+    u64 tick = 0;
+    u64 stepTicks = 1;
+    // What the slowest step since the previous snapshot took to simulate.
+    u64 stepCostTicks = 0;
+    u32 dropped = 0;
+    int asteroids = 0;
+    // World position of the view's top-left corner, now and a step ago.
+    // Sprites and particles are in world coordinates.
+    float cameraX = 0, cameraY = 0, prevCameraX = 0, prevCameraY = 0;
+
+    void reserve(int capacity, int particleCapacity) {
+        sprites.reserve(capacity);
+        particles.reserve(particleCapacity);
+    }
+    void clear() {
+        sprites.clear();
+        particles.clear();
+    }
+    void add(int image, SpriteLayer layer, float prevX, float prevY, float x, float y, float rotation = 0.0f, float scale = 1.0f,
+             float pivotX = 0.5f, float pivotY = 0.5f) {
+        if (sprites.size() == sprites.capacity()) {
+            dropped++;
+            return;
+        }
+        sprites.push_back(SpriteInstance{(u16)image, (u8)layer, prevX, prevY, x, y, rotation, scale, pivotX, pivotY});
+    }
+    void addParticle(float prevX, float prevY, float x, float y, u32 color, float size) {
+        if (particles.size() == particles.capacity()) {
+            dropped++;
+            return;
+        }
+        particles.push_back(ParticleInstance{prevX, prevY, x, y, color, size});
+    }
+    // Interpolation factor for drawing at system tick `now`: the picture runs
+    // one step behind the simulation and blends towards the latest state.
+    float alphaAt(u64 now) const {
+        if (now <= tick) return 0.0f;
+        float alpha = (float)(now - tick) / stepTicks;
+        return alpha > 1.0f ? 1.0f : alpha;
+    }
+    void cameraAt(float alpha, float & x, float & y) const {
+        x = prevCameraX + (cameraX - prevCameraX) * alpha;
+        y = prevCameraY + (cameraY - prevCameraY) * alpha;
+    }
+};
+
+// Turns snapshot sprites into batched draws against the atlas. Images and
+// their sizes are looked up once here, so each sprite only fills in its draw
+// parameters instead of going through the C2D_Sprite setters. Particles are
+// untextured squares, sent to the backend after the batch is flushed.
+//
+// Positions are moved from the world into the view by the snapshot's
+// camera, interpolated like everything else. Anything entirely outside the
+// view is culled before it reaches the batch.
+// A sprite is kept if the circle around its pivot that holds the sprite at
+// any rotation touches the view.
+class SnapshotRenderer {
+    C2D_Image images[ATLAS_IMAGE_COUNT];
+    float viewWidth, viewHeight;
+    u64 spritesSeen = 0, spritesCulled = 0, particlesSeen = 0, particlesCulled = 0;
+
+    bool offView(float x, float y, float reach) const {
+        return x + reach < 0 || y + reach < 0 || x - reach > viewWidth || y - reach > viewHeight;
+    }
+public:
+    SnapshotRenderer(C2D_SpriteSheet atlas, float viewWidth_ = TOP_WIDTH, float viewHeight_ = TOP_HEIGHT)
+        : viewWidth(viewWidth_), viewHeight(viewHeight_) {
+        for (int i = 0; i < ATLAS_IMAGE_COUNT; i++) {
+            images[i] = C2D_SpriteSheetGetImage(atlas, i);
+        }
+    }
+
+    void draw(const RenderSnapshot & snapshot, SpriteBatch & batch, float alpha) {
+        C2D_DrawParams params;
+        params.depth = 0.0f;
+        float camX, camY;
+        snapshot.cameraAt(alpha, camX, camY);
+        spritesSeen += snapshot.sprites.size();
+        for (const SpriteInstance & s : snapshot.sprites) {
+            const C2D_Image & image = images[s.image];
+            params.pos.w = image.subtex->width * s.scale;
+            params.pos.h = image.subtex->height * s.scale;
+            params.pos.x = s.prevX + (s.x - s.prevX) * alpha - camX;
+            params.pos.y = s.prevY + (s.y - s.prevY) * alpha - camY;
+            params.center.x = s.pivotX * params.pos.w;
+            params.center.y = s.pivotY * params.pos.h;
+            float reachX = std::max(params.center.x, params.pos.w - params.center.x);
+            float reachY = std::max(params.center.y, params.pos.h - params.center.y);
+            if (offView(params.pos.x, params.pos.y, std::sqrt(reachX * reachX + reachY * reachY))) {
+                spritesCulled++;
+                continue;
+            }
+            params.angle = s.rotation;
+            batch.add(image, params, (SpriteLayer)s.layer);
+        }
+    }
+
+    void drawParticles(const RenderSnapshot & snapshot, RenderBackend & backend, float alpha) {
+        float camX, camY;
+        snapshot.cameraAt(alpha, camX, camY);
+        particlesSeen += snapshot.particles.size();
+        for (const ParticleInstance & p : snapshot.particles) {
+            float half = p.size * 0.5f;
+            float x = p.prevX + (p.x - p.prevX) * alpha - camX, y = p.prevY + (p.y - p.prevY) * alpha - camY;
+            if (offView(x, y, half)) {
+                particlesCulled++;
+                continue;
+            }
+            backend.drawRect(x - half, y - half, p.size, p.size, p.color);
+        }
+    }
+
+    u64 spriteCount() const {
+        return spritesSeen;
+    }
+    u64 culledSprites() const {
+        return spritesCulled;
+    }
+    u64 particleCount() const {
+        return particlesSeen;
+    }
+    u64 culledParticles() const {
+        return particlesCulled;
+    }
+};
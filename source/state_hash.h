@@ -0,0 +1,30 @@
+#pragma once
+
+#include "main.h"
+
+// FNV-1a over the raw bytes of simulation state. Two runs of the same build
+// that hash equal after the same number of steps took identical paths.
+class StateHash {
+    u64 value = 14695981039346656037ULL;
+public:
+    void addBytes(const void* data, size_t size) {
+        const u8* bytes = (const u8*)data;
+        for (size_t i = 0; i < size; i++) {
+            value ^= bytes[i];
+            value *= 1099511628211ULL;
+        }
+    }
+    template<typename T>
+    void add(const T & field) {
+        addBytes(&field, sizeof(T));
+    }
+    template<typename T>
+    void add(const std::vector<T> & values) {
+        u32 count = values.size();
+        add(count);
+        if (count) addBytes(values.data(), count * sizeof(T));
+    }
+    u64 get() const {
+        return value;
+    }
+};
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "main.h"
+#include "profiler.h"
+#include <atomic>
+
+#define STRESS_MAX_ASTEROIDS 2048
+#define STRESS_START_COUNT 16
+#define STRESS_SETTLE_FRAMES 60
+// With vblank pacing a frame that keeps up takes exactly the budget and one
+// that misses a vblank takes twice that. A level the renderer can't keep up
+// with misses most of them, so frames get 10% of slack (about six misses a
+// second) and the odd late wake-up doesn't end the test.
+#define STRESS_FRAME_SLACK 1.10f
+
+// Finds how many asteroids the game can keep alive within its budgets: the
+// render thread's frame interval against frameBudgetMs, and the cost of one
+// simulation step against stepBudgetMs. The two run on separate threads, so
+// each is held to its own budget. The live count is raised by an eighth at a
+// time (at least 8). Each level is held until the field has filled up, then
+// judged on the average frame interval and step cost over the next
+// settleFrames frames. The first level over either budget ends the test; the
+// level before it is the sustainable maximum.
+//
+// frameFinished() is called by whoever times the frames; target() is read by
+// the simulation, possibly from another thread.
+class StressTest {
+    std::atomic<int> target{STRESS_START_COUNT};
+    int maxCount;
+    int settleFrames;
+    float frameBudgetMs, stepBudgetMs;
+    int waitedFrames = 0, judgedFrames = 0;
+    float judgedFrameMs = 0, judgedStepMs = 0, judgedLive = 0;
+    int sustainedCount = 0;
+    float sustainedFrameMs = 0, sustainedStepMs = 0;
+    int failedCount = 0;
+    float failedFrameMs = 0, failedStepMs = 0;
+    bool done = false;
+
+    void nextLevel(int count) {
+        waitedFrames = judgedFrames = 0;
+        judgedFrameMs = judgedStepMs = judgedLive = 0;
+        target.store(count, std::memory_order_relaxed);
+    }
+public:
+    StressTest(int maxCount_ = STRESS_MAX_ASTEROIDS, int settleFrames_ = STRESS_SETTLE_FRAMES,
+               float frameBudgetMs_ = FRAME_BUDGET_MS, float stepBudgetMs_ = STEP_BUDGET_MS)
+        : maxCount(maxCount_), settleFrames(settleFrames_), frameBudgetMs(frameBudgetMs_), stepBudgetMs(stepBudgetMs_) {
+    }
+
+    const std::atomic<int>* targetCount() const {
+        return &target;
+    }
+    bool finished() const {
+        return done;
+    }
+    int sustainableCount() const {
+        return sustainedCount;
+    }
+
+    // `frameMs` is the time since the previous frame, `stepMs` what the
+    // latest simulation step cost.
+    void frameFinished(float frameMs, float stepMs, int live) {
+        if (done) return;
+        int wanted = target.load(std::memory_order_relaxed);
+        // Asteroids that drift off screen are replaced a few per step, so a
+        // level counts as filled at 15/16 of its target. If it never gets
+        // there, judge it anyway after a while.
+        if (live < wanted - wanted / 16 && waitedFrames++ < settleFrames * 4) return;
+        judgedFrameMs += frameMs;
+        judgedStepMs += stepMs;
+        judgedLive += live;
+        if (++judgedFrames < settleFrames) return;
+
+        float averageFrameMs = judgedFrameMs / judgedFrames;
+        float averageStepMs = judgedStepMs / judgedFrames;
+        int averageLive = (int)(judgedLive / judgedFrames);
+        if (averageFrameMs > frameBudgetMs * STRESS_FRAME_SLACK || averageStepMs > stepBudgetMs) {
+            failedCount = averageLive;
+            failedFrameMs = averageFrameMs;
+            failedStepMs = averageStepMs;
+            done = true;
+            return;
+        }
+        sustainedCount = averageLive;
+        sustainedFrameMs = averageFrameMs;
+        sustainedStepMs = averageStepMs;
+        if (wanted >= maxCount) {
+            done = true;
+            return;
+        }
+        int raise = wanted / 8 > 8 ? wanted / 8 : 8;
+        nextLevel(wanted + raise < maxCount ? wanted + raise : maxCount);
+    }
+
+    void report(FILE* out) const {
+        fprintf(out, "Stress: %d asteroids sustained at %.2f ms a frame and %.2f ms a step (budgets %.2f and %.2f ms)",
+                sustainedCount, sustainedFrameMs, sustainedStepMs, frameBudgetMs, stepBudgetMs);
+        if (failedCount) {
+            fprintf(out, "; %d took %.2f ms a frame and %.2f ms a step\n", failedCount, failedFrameMs, failedStepMs);
+        } else if (done) {
+            fprintf(out, "; stopped at the %d cap\n", maxCount);
+        } else {
+            fprintf(out, "; still ramping at %d\n", target.load(std::memory_order_relaxed));
+        }
+    }
+};
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "main.h"
+
+#define SIM_MAX_SUBSTEPS 4
+
+// Hands real time out to the simulation in whole fixed-size steps, measured
+// in system ticks so the step count does not depend on osGetTime's 1 ms
+// resolution. If a frame owes more than maxSteps steps the excess is dropped,
+// so a long stall slows the game down for a moment instead of snowballing.
+class FixedTimestep {
+    u64 lastTick;
+    u64 accumulator = 0;
+    u64 stepTicks;
+    int maxSteps;
+    u64 droppedSteps = 0;
+public:
+    FixedTimestep(int hz = SIM_HZ, int maxSteps_ = SIM_MAX_SUBSTEPS) : stepTicks(SYSCLOCK_ARM11 / hz), maxSteps(maxSteps_) {
+        lastTick = svcGetSystemTick();
+    }
+
+    // Number of simulation steps to run this frame.
+    int advance() {
+        u64 now = svcGetSystemTick();
+        accumulator += now - lastTick;
+        lastTick = now;
+        u64 steps = accumulator / stepTicks;
+        accumulator %= stepTicks;
+        if (steps > (u64)maxSteps) {
+            droppedSteps += steps - maxSteps;
+            steps = maxSteps;
+        }
+        return steps;
+    }
+    u64 ticksPerStep() const {
+        return stepTicks;
+    }
+    // Ticks of real time left before the next step is due.
+    u64 ticksUntilNextStep() const {
+        return stepTicks - accumulator;
+    }
+    double stepSeconds() const {
+        return (double)stepTicks / SYSCLOCK_ARM11;
+    }
+    // How far the real clock is between the last simulated state and the
+    // next one, for render interpolation.
+    float alpha() const {
+        return (float)accumulator / stepTicks;
+    }
+    u64 dropped() const {
+        return droppedSteps;
+    }
+};
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "main.h"
+#include <atomic>
+
+// Single-producer, single-consumer handoff of the latest value without locks.
+// The writer always owns one slot and the reader another; the third sits in
+// the middle. publish() swaps the writer's slot into the middle and marks it
+// fresh, acquire() swaps the reader's slot out for a fresh middle. Neither
+// side ever waits, and the reader always sees the newest complete value; any
+// values published in between are simply skipped.
+//
+// Slots are default-constructed once and reused, so a T that reserves its
+// storage up front never allocates after setup.
+template<typename T>
+class TripleBuffer {
+    static const u8 INDEX_MASK = 0x3;
+    static const u8 FRESH = 0x4;
+
+    T slots[3];
+    std::atomic<u8> middle{1};
+    u8 back = 0;
+    u8 front = 2;
+public:
+    // Every slot, for sizing them before either thread starts.
+    T& slot(int i) {
+        return slots[i];
+    }
+
+    // Writer side.
+    T& writeBuffer() {
+        return slots[back];
+    }
+    void publish() {
+        back = middle.exchange(back | FRESH, std::memory_order_acq_rel) & INDEX_MASK;
+    }
+
+    // Reader side. Returns true if a newer value was picked up.
+    bool acquire() {
+        if (!(middle.load(std::memory_order_relaxed) & FRESH)) {
+            return false;
+        }
+        front = middle.exchange(front, std::memory_order_acq_rel) & INDEX_MASK;
+        return true;
+    }
+    const T& readBuffer() const {
+        return slots[front];
+    }
+};
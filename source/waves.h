@@ -0,0 +1,81 @@
+#pragma once
+
+#include "main.h"
+#include "state_hash.h"
+#include <atomic>
+
+#define WAVE_FIRST_DELAY_STEPS 240
+#define WAVE_STEPS (SIM_HZ * 30)
+#define WAVE_BASE_COUNT 10
+#define WAVE_COUNT_STEP 4
+#define WAVE_MAX_ASTEROIDS 40
+#define WAVE_SPEED_STEP 0.1f
+#define WAVE_MAX_SPEED_SCALE 2.0f
+// Spawning is spread out by count, not measured time, so a run stays a pure
+// function of its seed and input. Two a step refills a wave within a few
+// frames without ever adding a burst of new collision work in one step.
+#define WAVE_SPAWNS_PER_STEP 2
+#define STRESS_SPAWNS_PER_STEP 16
+
+// Decides how many asteroids should be alive and how many may be spawned this
+// step. After a quiet start, wave n wants WAVE_BASE_COUNT + (n - 1) *
+// WAVE_COUNT_STEP asteroids moving at 1 + (n - 1) * WAVE_SPEED_STEP times
+// their base speed. A new wave starts every WAVE_STEPS steps.
+//
+// With a stress target attached the waves stop: the live count follows the
+// target, which another thread may raise at any time.
+class WaveScheduler {
+    int wave = 0;
+    u32 stepsInWave = 0;
+    const std::atomic<int>* stressTarget = nullptr;
+public:
+    void setStressTarget(const std::atomic<int>* target) {
+        stressTarget = target;
+    }
+    bool stressing() const {
+        return stressTarget != nullptr;
+    }
+    int waveNumber() const {
+        return wave;
+    }
+
+    int targetCount(int limit) const {
+        int target = 0;
+        if (stressTarget) {
+            target = stressTarget->load(std::memory_order_relaxed);
+        } else if (wave > 0) {
+            target = WAVE_BASE_COUNT + (wave - 1) * WAVE_COUNT_STEP;
+        }
+        return target < limit ? target : limit;
+    }
+    float speedScale() const {
+        if (stressTarget || wave <= 1) return 1.0f;
+        float scale = 1.0f + (wave - 1) * WAVE_SPEED_STEP;
+        return scale < WAVE_MAX_SPEED_SCALE ? scale : WAVE_MAX_SPEED_SCALE;
+    }
+
+    // Advances one step and returns how many asteroids to spawn in it.
+    int step(int live, int limit) {
+        stepsInWave++;
+        if (stressTarget) {
+            if (wave == 0) wave = 1;
+        } else if (wave == 0 ? stepsInWave > WAVE_FIRST_DELAY_STEPS : stepsInWave >= WAVE_STEPS) {
+            wave++;
+            stepsInWave = 0;
+        }
+        int target = targetCount(limit);
+        int missing = target - live;
+        int budget = WAVE_SPAWNS_PER_STEP;
+        if (stressTarget) {
+            // Large stress levels would never fill at a fixed rate.
+            budget = target / 32 > STRESS_SPAWNS_PER_STEP ? target / 32 : STRESS_SPAWNS_PER_STEP;
+        }
+        if (missing <= 0) return 0;
+        return missing < budget ? missing : budget;
+    }
+
+    void hashState(StateHash & hash) const {
+        hash.add(wave);
+        hash.add(stepsInWave);
+    }
+};
@@ -0,0 +1,143 @@
+#pragma once
+
+#include "main.h"
+#include "random.h"
+#include "state_hash.h"
+
+// The play field is WORLD_CHUNKS_X x WORLD_CHUNKS_Y square chunks, many
+// screens across, and the camera follows the player. Only the chunks within
+// WORLD_LIVE_RADIUS of the player's chunk exist. Those within
+// WORLD_NEAR_RADIUS cover the screen wherever the player is in their chunk.
+// They are simulated every step. The rest of the live chunks are off screen
+// and only step once every WORLD_FAR_INTERVAL steps. Chunks are created
+// as they come into range and evicted with everything in them when they
+// leave, so memory and work depend on the radii, not the world's size.
+//
+// The world stays under 32768 pixels across so 16.16 fixed-point physics
+// can still hold any position.
+#define WORLD_CHUNK_SIZE 200.0f
+#define WORLD_CHUNKS_X 64
+#define WORLD_CHUNKS_Y 64
+#define WORLD_WIDTH (WORLD_CHUNKS_X * WORLD_CHUNK_SIZE)
+#define WORLD_HEIGHT (WORLD_CHUNKS_Y * WORLD_CHUNK_SIZE)
+#define WORLD_NEAR_RADIUS 1
+#define WORLD_LIVE_RADIUS 3
+#define WORLD_LIVE_CHUNKS ((2 * WORLD_LIVE_RADIUS + 1) * (2 * WORLD_LIVE_RADIUS + 1))
+#define WORLD_FAR_INTERVAL 4
+// Most drifting rocks a chunk starts with when it is created off screen.
+#define WORLD_ROCKS_PER_CHUNK 3
+
+// An inclusive range of chunk coordinates.
+struct ChunkRect {
+    int x0 = 0, y0 = 0, x1 = -1, y1 = -1;
+
+    bool contains(int cx, int cy) const {
+        return cx >= x0 && cx <= x1 && cy >= y0 && cy <= y1;
+    }
+    int count() const {
+        return (x1 - x0 + 1) * (y1 - y0 + 1);
+    }
+};
+
+inline int chunkOf(float coordinate) {
+    return (int)floorf(coordinate / WORLD_CHUNK_SIZE);
+}
+
+// Top-left corner of the screen for a player at (x, y): centred on the
+// player, but never showing past the world's edge.
+inline void cameraFor(float x, float y, float & cameraX, float & cameraY) {
+    cameraX = std::clamp(x - TOP_WIDTH / 2.0f, 0.0f, WORLD_WIDTH - TOP_WIDTH);
+    cameraY = std::clamp(y - TOP_HEIGHT / 2.0f, 0.0f, WORLD_HEIGHT - TOP_HEIGHT);
+}
+
+// Tracks which chunks are live and near. Chunks carry no state of their
+// own: whatever is in a chunk is found by position, and a chunk's starting
+// contents come from its own generator, seeded from the world seed and its
+// coordinates. A chunk that is evicted and later created again starts over.
+class WorldStreamer {
+    u64 seed;
+    int centreX = -1, centreY = -1;
+    ChunkRect live, near;
+    u32 created = 0, evicted = 0;
+
+    static ChunkRect around(int cx, int cy, int radius) {
+        ChunkRect rect;
+        rect.x0 = std::max(cx - radius, 0);
+        rect.y0 = std::max(cy - radius, 0);
+        rect.x1 = std::min(cx + radius, WORLD_CHUNKS_X - 1);
+        rect.y1 = std::min(cy + radius, WORLD_CHUNKS_Y - 1);
+        return rect;
+    }
+public:
+    explicit WorldStreamer(u64 seed_) : seed(seed_) {}
+
+    // Centres the live chunks on the chunk holding (x, y) and returns
+    // whether they moved. If they did, evict() is called first, so whatever
+    // is no longer live can go, then create(cx, cy) for each chunk that
+    // came into range. A new chunk is therefore populated into a world that
+    // only holds live things.
+    template<typename Evict, typename Create>
+    bool follow(float x, float y, Evict && evict, Create && create) {
+        int cx = std::clamp(chunkOf(x), 0, WORLD_CHUNKS_X - 1);
+        int cy = std::clamp(chunkOf(y), 0, WORLD_CHUNKS_Y - 1);
+        if (cx == centreX && cy == centreY) {
+            return false;
+        }
+        ChunkRect previous = live;
+        centreX = cx;
+        centreY = cy;
+        live = around(cx, cy, WORLD_LIVE_RADIUS);
+        near = around(cx, cy, WORLD_NEAR_RADIUS);
+        for (int row = previous.y0; row <= previous.y1; row++) {
+            for (int col = previous.x0; col <= previous.x1; col++) {
+                if (!live.contains(col, row)) evicted++;
+            }
+        }
+        evict();
+        for (int row = live.y0; row <= live.y1; row++) {
+            for (int col = live.x0; col <= live.x1; col++) {
+                if (!previous.contains(col, row)) {
+                    created++;
+                    create(col, row);
+                }
+            }
+        }
+        return true;
+    }
+
+    bool isLive(float x, float y) const {
+        return live.contains(chunkOf(x), chunkOf(y));
+    }
+    bool isNear(float x, float y) const {
+        return near.contains(chunkOf(x), chunkOf(y));
+    }
+    bool isNearChunk(int cx, int cy) const {
+        return near.contains(cx, cy);
+    }
+    // World position of the near chunks' top-left corner.
+    float nearOriginX() const {
+        return near.x0 * WORLD_CHUNK_SIZE;
+    }
+    float nearOriginY() const {
+        return near.y0 * WORLD_CHUNK_SIZE;
+    }
+
+    // Generator for a chunk's starting contents.
+    Rng chunkRng(int cx, int cy) const {
+        return Rng(seed, ((u64)(u32)cx << 32) | (u32)cy);
+    }
+
+    int liveCount() const {
+        return live.count();
+    }
+    u32 createdCount() const {
+        return created;
+    }
+    u32 evictedCount() const {
+        return evicted;
+    }
+    void hashState(StateHash & hash) const {
+        hash.add(centreX);
+        hash.add(centreY);
+    }
+};
@@ -0,0 +1,107 @@
+// Packs asset files into one indexed archive the game reads in a single pass.
+//
+//   asset_pack <out.pak> name=file [name=file ...]
+//
+// The format of each entry comes from the file extension (.t3x, .wav, or raw
+// for anything else). Entries are sorted by name so the game can binary
+// search the index. See source/pak_format.h for the layout.
+#include "pak_format.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Input {
+    std::string name;
+    std::vector<uint8_t> data;
+    uint32_t format;
+};
+
+bool endsWith(const std::string& s, const char* suffix) {
+    size_t n = strlen(suffix);
+    return s.size() >= n && s.compare(s.size() - n, n, suffix) == 0;
+}
+
+bool readFile(const std::string& path, std::vector<uint8_t>& out) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) return false;
+    uint8_t buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), file)) > 0) out.insert(out.end(), buf, buf + n);
+    fclose(file);
+    return true;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s <out.pak> name=file ...\n", argv[0]);
+        return 1;
+    }
+
+    std::vector<Input> inputs;
+    for (int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        size_t eq = arg.find('=');
+        if (eq == std::string::npos) {
+            fprintf(stderr, "expected name=path, got %s\n", arg.c_str());
+            return 1;
+        }
+        Input input;
+        input.name = arg.substr(0, eq);
+        std::string path = arg.substr(eq + 1);
+        if (input.name.size() >= PAK_NAME_LENGTH) {
+            fprintf(stderr, "name too long (max %d): %s\n", PAK_NAME_LENGTH - 1, input.name.c_str());
+            return 1;
+        }
+        if (!readFile(path, input.data)) {
+            fprintf(stderr, "cannot read %s\n", path.c_str());
+            return 1;
+        }
+        input.format = endsWith(path, ".t3x") ? PAK_FORMAT_T3X : endsWith(path, ".wav") ? PAK_FORMAT_WAV : PAK_FORMAT_RAW;
+        inputs.push_back(input);
+    }
+    std::sort(inputs.begin(), inputs.end(), [](const Input& a, const Input& b) { return a.name < b.name; });
+    for (size_t i = 1; i < inputs.size(); i++) {
+        if (inputs[i].name == inputs[i - 1].name) {
+            fprintf(stderr, "duplicate name %s\n", inputs[i].name.c_str());
+            return 1;
+        }
+    }
+
+    PakHeader header = {PAK_MAGIC, PAK_VERSION, (uint32_t)inputs.size(), 0};
+    std::vector<PakEntry> entries(inputs.size());
+    size_t offset = sizeof(PakHeader) + entries.size() * sizeof(PakEntry);
+    for (size_t i = 0; i < inputs.size(); i++) {
+        offset = (offset + PAK_ALIGN - 1) & ~(size_t)(PAK_ALIGN - 1);
+        memset(&entries[i], 0, sizeof(PakEntry));
+        memcpy(entries[i].name, inputs[i].name.c_str(), inputs[i].name.size());
+        entries[i].offset = offset;
+        entries[i].size = inputs[i].data.size();
+        entries[i].format = inputs[i].format;
+        entries[i].crc32 = pakCrc32(inputs[i].data.data(), inputs[i].data.size());
+        offset += inputs[i].data.size();
+    }
+
+    std::vector<uint8_t> out(offset, 0);
+    memcpy(out.data(), &header, sizeof(header));
+    memcpy(out.data() + sizeof(header), entries.data(), entries.size() * sizeof(PakEntry));
+    for (size_t i = 0; i < inputs.size(); i++) {
+        memcpy(out.data() + entries[i].offset, inputs[i].data.data(), inputs[i].data.size());
+    }
+
+    FILE* file = fopen(argv[1], "wb");
+    if (!file || fwrite(out.data(), 1, out.size(), file) != out.size()) {
+        fprintf(stderr, "cannot write %s\n", argv[1]);
+        if (file) fclose(file);
+        return 1;
+    }
+    fclose(file);
+    printf("Packed %zu assets into %s (%zu bytes)\n", inputs.size(), argv[1], out.size());
+    return 0;
+}
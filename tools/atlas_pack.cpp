@@ -0,0 +1,274 @@
+// Packs several .t3x sprite sheets into one texture atlas.
+//
+//   atlas_pack <out.t3x> <out_index.h> <out_masks.h> name=sheet.t3x[,mask] ...
+//
+// Every subimage of every input becomes a subimage of the atlas. The index
+// header gives each one an enum value: ATLAS_<NAME> for single-image sheets
+// and ATLAS_<NAME>_<i> for multi-image sheets, in input order. Sheets marked
+// `,mask` also get a 1-bit alpha mask per subimage in the masks header, for
+// pixel-accurate collision (see source/collision_mask.h).
+#include "t3x.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Entry {
+    std::string name;
+    t3x::Image image;
+    bool mask = false;
+    int x = 0, y = 0;
+};
+
+// Pixels at least this opaque are solid.
+const int MASK_ALPHA_THRESHOLD = 128;
+
+// Writes the rows of `image`'s alpha mask as words, pixel x in bit x % 32 of
+// word x / 32, and returns the distance from the image centre to the
+// farthest corner of any solid pixel. Images come out of the sheets in
+// texture row order, which citro2d draws bottom row first (the rocket's
+// flame is in row 0), so rows are written last to first to put the top of
+// the sprite as drawn first.
+float appendMask(const t3x::Image& image, std::vector<uint32_t>& bits) {
+    int wordsPerRow = (image.width + 31) / 32;
+    float cx = image.width * 0.5f, cy = image.height * 0.5f, radiusSq = 0;
+    for (int y = 0; y < image.height; y++) {
+        size_t row = bits.size();
+        bits.resize(row + wordsPerRow, 0);
+        for (int x = 0; x < image.width; x++) {
+            if (image.pixel(x, image.height - 1 - y)[3] < MASK_ALPHA_THRESHOLD) continue;
+            bits[row + x / 32] |= 1u << (x % 32);
+            float dx = std::max(std::abs(x - cx), std::abs(x + 1 - cx));
+            float dy = std::max(std::abs(y - cy), std::abs(y + 1 - cy));
+            radiusSq = std::max(radiusSq, dx * dx + dy * dy);
+        }
+    }
+    return std::sqrt(radiusSq);
+}
+
+// Bottom-left skyline packer. Each rectangle reserves one extra pixel to the
+// right and below so linear filtering never samples a neighbour.
+class Skyline {
+    struct Segment {
+        int x, y, width;
+    };
+    int width, height;
+    std::vector<Segment> segments;
+
+    bool fits(size_t index, int w, int h, int& outY) const {
+        int x = segments[index].x;
+        if (x + w > width) return false;
+        int remaining = w, y = 0;
+        for (size_t i = index; remaining > 0; i++) {
+            if (i >= segments.size()) return false;
+            y = std::max(y, segments[i].y);
+            if (y + h > height) return false;
+            remaining -= segments[i].width;
+        }
+        outY = y;
+        return true;
+    }
+
+public:
+    Skyline(int width_, int height_) : width(width_), height(height_) {
+        segments.push_back({0, 0, width});
+    }
+
+    bool place(int w, int h, int& outX, int& outY) {
+        int bestIndex = -1, bestTop = 0, bestX = 0, bestY = 0;
+        for (size_t i = 0; i < segments.size(); i++) {
+            int y;
+            if (!fits(i, w, h, y)) continue;
+            if (bestIndex < 0 || y + h < bestTop || (y + h == bestTop && segments[i].x < bestX)) {
+                bestIndex = i;
+                bestTop = y + h;
+                bestX = segments[i].x;
+                bestY = y;
+            }
+        }
+        if (bestIndex < 0) return false;
+
+        Segment placed = {bestX, bestY + h, w};
+        segments.insert(segments.begin() + bestIndex, placed);
+        for (size_t i = bestIndex + 1; i < segments.size();) {
+            int overlap = placed.x + placed.width - segments[i].x;
+            if (overlap <= 0) break;
+            segments[i].x += overlap;
+            segments[i].width -= overlap;
+            if (segments[i].width <= 0) {
+                segments.erase(segments.begin() + i);
+            } else {
+                break;
+            }
+        }
+        for (size_t i = 0; i + 1 < segments.size();) {
+            if (segments[i].y == segments[i + 1].y) {
+                segments[i].width += segments[i + 1].width;
+                segments.erase(segments.begin() + i + 1);
+            } else {
+                i++;
+            }
+        }
+        outX = bestX;
+        outY = bestY;
+        return true;
+    }
+};
+
+bool pack(std::vector<Entry>& entries, int width, int height) {
+    std::vector<Entry*> order;
+    for (auto& entry : entries) order.push_back(&entry);
+    std::stable_sort(order.begin(), order.end(), [](const Entry* a, const Entry* b) {
+        return a->image.height > b->image.height;
+    });
+    Skyline skyline(width, height);
+    for (Entry* entry : order) {
+        if (entry->image.width > width || entry->image.height > height) return false;
+        int w = entry->image.width + (entry->image.width < width ? 1 : 0);
+        int h = entry->image.height + (entry->image.height < height ? 1 : 0);
+        if (!skyline.place(w, h, entry->x, entry->y)) return false;
+    }
+    return true;
+}
+
+std::string enumName(const std::string& name) {
+    std::string out = "ATLAS_";
+    for (char c : name) {
+        out += std::isalnum((unsigned char)c) ? (char)std::toupper((unsigned char)c) : '_';
+    }
+    return out;
+}
+
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 5) {
+        fprintf(stderr, "usage: %s <out.t3x> <out_index.h> <out_masks.h> name=sheet.t3x[,mask] ...\n", argv[0]);
+        return 1;
+    }
+
+    std::vector<Entry> entries;
+    for (int i = 4; i < argc; i++) {
+        std::string arg = argv[i];
+        bool mask = arg.size() > 5 && arg.compare(arg.size() - 5, 5, ",mask") == 0;
+        if (mask) {
+            arg.resize(arg.size() - 5);
+        }
+        size_t eq = arg.find('=');
+        if (eq == std::string::npos) {
+            fprintf(stderr, "expected name=path, got %s\n", arg.c_str());
+            return 1;
+        }
+        std::string name = arg.substr(0, eq), path = arg.substr(eq + 1);
+        t3x::Sheet sheet;
+        std::string error;
+        if (!t3x::load(path, sheet, error)) {
+            fprintf(stderr, "%s\n", error.c_str());
+            return 1;
+        }
+        for (size_t sub = 0; sub < sheet.subtextures.size(); sub++) {
+            Entry entry;
+            entry.name = sheet.subtextures.size() == 1 ? name : name + "_" + std::to_string(sub);
+            entry.image = sheet.extract(sub);
+            entry.mask = mask;
+            entries.push_back(entry);
+        }
+    }
+
+    // Smallest power-of-two texture (by area, then squarer) that fits.
+    std::vector<std::pair<int, int>> sizes;
+    for (int w = 8; w <= 1024; w *= 2) {
+        for (int h = 8; h <= 1024; h *= 2) sizes.push_back({w, h});
+    }
+    std::sort(sizes.begin(), sizes.end(), [](const std::pair<int, int>& a, const std::pair<int, int>& b) {
+        if (a.first * a.second != b.first * b.second) return a.first * a.second < b.first * b.second;
+        return std::max(a.first, a.second) < std::max(b.first, b.second);
+    });
+    int width = 0, height = 0;
+    for (auto& size : sizes) {
+        if (pack(entries, size.first, size.second)) {
+            width = size.first;
+            height = size.second;
+            break;
+        }
+    }
+    if (!width) {
+        fprintf(stderr, "images do not fit in a 1024x1024 texture\n");
+        return 1;
+    }
+
+    t3x::Sheet atlas;
+    atlas.texture.width = width;
+    atlas.texture.height = height;
+    atlas.texture.rgba.assign(width * height * 4, 0);
+    for (auto& entry : entries) {
+        for (int y = 0; y < entry.image.height; y++) {
+            for (int x = 0; x < entry.image.width; x++) {
+                const uint8_t* src = entry.image.pixel(x, y);
+                std::copy(src, src + 4, atlas.texture.pixel(entry.x + x, entry.y + y));
+            }
+        }
+        atlas.subtextures.push_back({entry.image.width, entry.image.height, entry.x, entry.y});
+    }
+    if (!t3x::save(argv[1], atlas)) {
+        fprintf(stderr, "cannot write %s\n", argv[1]);
+        return 1;
+    }
+
+    FILE* header = fopen(argv[2], "w");
+    if (!header) {
+        fprintf(stderr, "cannot write %s\n", argv[2]);
+        return 1;
+    }
+    fprintf(header, "// Generated by tools/atlas_pack; do not edit. Regenerate with the `atlas` CMake target.\n");
+    fprintf(header, "#pragma once\n\n");
+    fprintf(header, "// Name of the atlas in the asset archive.\n#define ATLAS_ASSET \"atlas\"\n");
+    fprintf(header, "#define ATLAS_WIDTH %d\n#define ATLAS_HEIGHT %d\n\n", width, height);
+    fprintf(header, "enum AtlasImage {\n");
+    for (size_t i = 0; i < entries.size(); i++) {
+        fprintf(header, "    %s = %zu,\n", enumName(entries[i].name).c_str(), i);
+    }
+    fprintf(header, "    ATLAS_IMAGE_COUNT = %zu\n};\n", entries.size());
+    fclose(header);
+
+    FILE* masks = fopen(argv[3], "w");
+    if (!masks) {
+        fprintf(stderr, "cannot write %s\n", argv[3]);
+        return 1;
+    }
+    std::vector<uint32_t> bits;
+    std::string table;
+    int maskCount = 0;
+    for (size_t i = 0; i < entries.size(); i++) {
+        if (!entries[i].mask) continue;
+        size_t offset = bits.size();
+        float radius = appendMask(entries[i].image, bits);
+        char line[160];
+        snprintf(line, sizeof(line), "    {%s, %d, %d, %zu, %.2ff},\n", enumName(entries[i].name).c_str(),
+                 entries[i].image.width, entries[i].image.height, offset, radius);
+        table += line;
+        maskCount++;
+    }
+    fprintf(masks, "// Generated by tools/atlas_pack; do not edit. Regenerate with the `atlas` CMake target.\n");
+    fprintf(masks, "#pragma once\n\n#include \"atlas_index.h\"\n\n#include <stdint.h>\n\n");
+    fprintf(masks, "// Alpha >= %d is solid. Rows top first, (width + 31) / 32 words each, with\n", MASK_ALPHA_THRESHOLD);
+    fprintf(masks, "// pixel x in bit x %% 32 of word x / 32. `radius` reaches every solid pixel\n");
+    fprintf(masks, "// from the centre of the image.\n");
+    fprintf(masks, "struct AtlasMask {\n    int image;\n    int width, height;\n    int offset;\n    float radius;\n};\n\n");
+    fprintf(masks, "#define ATLAS_MASK_COUNT %d\n", maskCount);
+    fprintf(masks, "static const AtlasMask ATLAS_MASKS[ATLAS_MASK_COUNT] = {\n%s};\n\n", table.c_str());
+    fprintf(masks, "static const uint32_t ATLAS_MASK_BITS[%zu] = {", bits.size());
+    for (size_t i = 0; i < bits.size(); i++) {
+        fprintf(masks, "%s0x%08x,", i % 8 ? " " : "\n    ", bits[i]);
+    }
+    fprintf(masks, "\n};\n");
+    fclose(masks);
+
+    printf("Packed %zu images into %dx%d\n", entries.size(), width, height);
+    return 0;
+}
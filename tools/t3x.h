@@ -0,0 +1,321 @@
+// Reading and writing Tex3DS (.t3x) sprite sheets on the host.
+// Only what the game's assets use is supported: RGBA8 textures without
+// mipmaps, stored uncompressed or LZ11-compressed.
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace t3x {
+
+// An RGBA image with row 0 at the top, 4 bytes per pixel in R,G,B,A order.
+struct Image {
+    int width = 0;
+    int height = 0;
+    std::vector<uint8_t> rgba;
+
+    uint8_t* pixel(int x, int y) {
+        return &rgba[(y * width + x) * 4];
+    }
+    const uint8_t* pixel(int x, int y) const {
+        return &rgba[(y * width + x) * 4];
+    }
+};
+
+struct SubTexture {
+    int width, height;
+    // Pixel rectangle inside the texture, top-left origin.
+    int x, y;
+};
+
+struct Sheet {
+    Image texture;
+    std::vector<SubTexture> subtextures;
+
+    Image extract(size_t index) const {
+        const SubTexture& sub = subtextures[index];
+        Image out;
+        out.width = sub.width;
+        out.height = sub.height;
+        out.rgba.resize(sub.width * sub.height * 4);
+        for (int y = 0; y < sub.height; y++) {
+            for (int x = 0; x < sub.width; x++) {
+                const uint8_t* src = texture.pixel(sub.x + x, sub.y + y);
+                std::copy(src, src + 4, out.pixel(x, y));
+            }
+        }
+        return out;
+    }
+};
+
+enum { GPU_RGBA8 = 0 };
+
+// The GPU stores textures bottom row first in 8x8 tiles, with the pixels of
+// each tile in Morton (Z) order.
+inline size_t tiledOffset(int x, int y, int width, int height) {
+    int memY = height - 1 - y;
+    int tile = (memY / 8) * (width / 8) + (x / 8);
+    int tx = x & 7, ty = memY & 7;
+    int morton = (tx & 1) | ((ty & 1) << 1) | ((tx & 2) << 1) | ((ty & 2) << 2) | ((tx & 4) << 2) | ((ty & 4) << 3);
+    return (size_t)(tile * 64 + morton) * 4;
+}
+
+inline bool lz11Decompress(const uint8_t* in, size_t inSize, std::vector<uint8_t>& out, size_t outSize) {
+    out.assign(outSize, 0);
+    size_t ip = 0, op = 0;
+    while (op < outSize) {
+        if (ip >= inSize) return false;
+        uint8_t flags = in[ip++];
+        for (int bit = 7; bit >= 0 && op < outSize; bit--) {
+            if (!(flags & (1 << bit))) {
+                if (ip >= inSize) return false;
+                out[op++] = in[ip++];
+                continue;
+            }
+            if (ip + 1 >= inSize) return false;
+            uint8_t b0 = in[ip++];
+            size_t len, disp;
+            switch (b0 >> 4) {
+            case 0: {
+                uint8_t b1 = in[ip++], b2 = in[ip++];
+                len = (((b0 & 0xF) << 4) | (b1 >> 4)) + 0x11;
+                disp = (((b1 & 0xF) << 8) | b2) + 1;
+                break;
+            }
+            case 1: {
+                uint8_t b1 = in[ip++], b2 = in[ip++], b3 = in[ip++];
+                len = (((b0 & 0xF) << 12) | (b1 << 4) | (b2 >> 4)) + 0x111;
+                disp = (((b2 & 0xF) << 8) | b3) + 1;
+                break;
+            }
+            default: {
+                uint8_t b1 = in[ip++];
+                len = (b0 >> 4) + 1;
+                disp = (((b0 & 0xF) << 8) | b1) + 1;
+                break;
+            }
+            }
+            if (disp > op) return false;
+            for (size_t i = 0; i < len && op < outSize; i++, op++) {
+                out[op] = out[op - disp];
+            }
+        }
+    }
+    return true;
+}
+
+// Greedy LZ11 with hash chains; slow but only run offline.
+inline std::vector<uint8_t> lz11Compress(const std::vector<uint8_t>& in) {
+    const size_t window = 4096, maxLen = 0x10110, minLen = 3;
+    std::vector<uint8_t> out;
+    out.push_back(0x11);
+    out.push_back(in.size() & 0xFF);
+    out.push_back((in.size() >> 8) & 0xFF);
+    out.push_back((in.size() >> 16) & 0xFF);
+
+    std::vector<int> head(1 << 16, -1), prev(in.size(), -1);
+    auto hash = [&](size_t p) {
+        return ((in[p] << 8) ^ (in[p + 1] << 4) ^ in[p + 2]) & 0xFFFF;
+    };
+    auto insert = [&](size_t p) {
+        if (p + 2 < in.size()) {
+            int h = hash(p);
+            prev[p] = head[h];
+            head[h] = p;
+        }
+    };
+
+    size_t pos = 0;
+    while (pos < in.size()) {
+        size_t flagPos = out.size();
+        out.push_back(0);
+        for (int bit = 7; bit >= 0 && pos < in.size(); bit--) {
+            size_t bestLen = 0, bestDisp = 0;
+            if (pos + 2 < in.size()) {
+                int chain = 0;
+                for (int cand = head[hash(pos)]; cand >= 0 && pos - cand <= window && chain < 128; cand = prev[cand], chain++) {
+                    size_t len = 0;
+                    while (len < maxLen && pos + len < in.size() && in[cand + len] == in[pos + len]) len++;
+                    if (len > bestLen) {
+                        bestLen = len;
+                        bestDisp = pos - cand;
+                    }
+                }
+            }
+            if (bestLen < minLen) {
+                out.push_back(in[pos]);
+                insert(pos);
+                pos++;
+                continue;
+            }
+            out[flagPos] |= 1 << bit;
+            size_t d = bestDisp - 1;
+            if (bestLen <= 0x10) {
+                out.push_back(((bestLen - 1) << 4) | (d >> 8));
+                out.push_back(d & 0xFF);
+            } else if (bestLen <= 0x110) {
+                size_t l = bestLen - 0x11;
+                out.push_back(l >> 4);
+                out.push_back(((l & 0xF) << 4) | (d >> 8));
+                out.push_back(d & 0xFF);
+            } else {
+                size_t l = bestLen - 0x111;
+                out.push_back(0x10 | (l >> 12));
+                out.push_back((l >> 4) & 0xFF);
+                out.push_back(((l & 0xF) << 4) | (d >> 8));
+                out.push_back(d & 0xFF);
+            }
+            for (size_t i = 0; i < bestLen; i++) insert(pos + i);
+            pos += bestLen;
+        }
+    }
+    while (out.size() % 4) out.push_back(0);
+    return out;
+}
+
+inline uint16_t readU16(const std::vector<uint8_t>& data, size_t offset) {
+    return data[offset] | (data[offset + 1] << 8);
+}
+
+inline bool load(const std::string& path, Sheet& sheet, std::string& error) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (!file) {
+        error = "cannot open " + path;
+        return false;
+    }
+    std::vector<uint8_t> data;
+    uint8_t buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), file)) > 0) data.insert(data.end(), buf, buf + n);
+    fclose(file);
+
+    if (data.size() < 5) {
+        error = path + ": truncated header";
+        return false;
+    }
+    size_t count = readU16(data, 0);
+    int width = 1 << ((data[2] & 7) + 3);
+    int height = 1 << (((data[2] >> 3) & 7) + 3);
+    if (data[3] != GPU_RGBA8 || data[4] != 0) {
+        error = path + ": only RGBA8 without mipmaps is supported";
+        return false;
+    }
+    size_t offset = 5;
+    sheet.subtextures.clear();
+    for (size_t i = 0; i < count; i++) {
+        if (offset + 12 > data.size()) {
+            error = path + ": truncated subtexture table";
+            return false;
+        }
+        SubTexture sub;
+        sub.width = readU16(data, offset);
+        sub.height = readU16(data, offset + 2);
+        float left = readU16(data, offset + 4) / 1024.0f;
+        float top = readU16(data, offset + 6) / 1024.0f;
+        sub.x = (int)(left * width + 0.5f);
+        sub.y = (int)((1.0f - top) * height + 0.5f);
+        sheet.subtextures.push_back(sub);
+        offset += 12;
+    }
+
+    uint8_t type = data[offset];
+    size_t rawSize = data[offset + 1] | (data[offset + 2] << 8) | (data[offset + 3] << 16);
+    offset += 4;
+    if (rawSize == 0) {
+        rawSize = data[offset] | (data[offset + 1] << 8) | (data[offset + 2] << 16) | ((size_t)data[offset + 3] << 24);
+        offset += 4;
+    }
+    std::vector<uint8_t> raw;
+    if (type == 0x00) {
+        raw.assign(data.begin() + offset, data.begin() + std::min(data.size(), offset + rawSize));
+        raw.resize(rawSize);
+    } else if (type == 0x11) {
+        if (!lz11Decompress(data.data() + offset, data.size() - offset, raw, rawSize)) {
+            error = path + ": corrupt LZ11 data";
+            return false;
+        }
+    } else {
+        error = path + ": unsupported compression";
+        return false;
+    }
+    if (raw.size() < (size_t)width * height * 4) {
+        error = path + ": texture data too short";
+        return false;
+    }
+
+    sheet.texture.width = width;
+    sheet.texture.height = height;
+    sheet.texture.rgba.resize(width * height * 4);
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            const uint8_t* src = &raw[tiledOffset(x, y, width, height)];
+            uint8_t* dst = sheet.texture.pixel(x, y);
+            dst[0] = src[3];
+            dst[1] = src[2];
+            dst[2] = src[1];
+            dst[3] = src[0];
+        }
+    }
+    return true;
+}
+
+inline int log2Exact(int value) {
+    int log = 0;
+    while ((1 << log) < value) log++;
+    return log;
+}
+
+inline void writeU16(std::vector<uint8_t>& out, uint16_t value) {
+    out.push_back(value & 0xFF);
+    out.push_back(value >> 8);
+}
+
+// Texture dimensions must be powers of two between 8 and 1024.
+inline bool save(const std::string& path, const Sheet& sheet, bool compress = true) {
+    const Image& tex = sheet.texture;
+    std::vector<uint8_t> out;
+    writeU16(out, sheet.subtextures.size());
+    out.push_back(((log2Exact(tex.width) - 3) & 7) | (((log2Exact(tex.height) - 3) & 7) << 3));
+    out.push_back(GPU_RGBA8);
+    out.push_back(0);
+    for (const SubTexture& sub : sheet.subtextures) {
+        writeU16(out, sub.width);
+        writeU16(out, sub.height);
+        writeU16(out, (uint16_t)((float)sub.x / tex.width * 1024.0f + 0.5f));
+        writeU16(out, (uint16_t)((1.0f - (float)sub.y / tex.height) * 1024.0f + 0.5f));
+        writeU16(out, (uint16_t)((float)(sub.x + sub.width) / tex.width * 1024.0f + 0.5f));
+        writeU16(out, (uint16_t)((1.0f - (float)(sub.y + sub.height) / tex.height) * 1024.0f + 0.5f));
+    }
+
+    std::vector<uint8_t> raw(tex.width * tex.height * 4);
+    for (int y = 0; y < tex.height; y++) {
+        for (int x = 0; x < tex.width; x++) {
+            const uint8_t* src = tex.pixel(x, y);
+            uint8_t* dst = &raw[tiledOffset(x, y, tex.width, tex.height)];
+            dst[0] = src[3];
+            dst[1] = src[2];
+            dst[2] = src[1];
+            dst[3] = src[0];
+        }
+    }
+    if (compress) {
+        std::vector<uint8_t> packed = lz11Compress(raw);
+        out.insert(out.end(), packed.begin(), packed.end());
+    } else {
+        out.push_back(0x00);
+        out.push_back(raw.size() & 0xFF);
+        out.push_back((raw.size() >> 8) & 0xFF);
+        out.push_back((raw.size() >> 16) & 0xFF);
+        out.insert(out.end(), raw.begin(), raw.end());
+    }
+
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) return false;
+    bool ok = fwrite(out.data(), 1, out.size(), file) == out.size();
+    fclose(file);
+    return ok;
+}
+
+}